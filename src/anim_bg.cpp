@@ -0,0 +1,416 @@
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <SDL2/SDL.h>
+
+#include "core.h"
+#include "anim_bg.h"
+#include "asset_pack.h"
+#include "bstrlib.h"
+#include "debug.h"
+#include "gfx_structures.h"
+
+static SDL_Surface *load_frame(struct anim_bg *a, int frame)
+{
+    SDL_Surface *s = NULL;
+    SDL_RWops *rw = NULL;
+    bstring name = NULL;
+
+    if(a->pack_name)
+    {
+        name = bformat("%s/%05d", a->pack_name, frame);
+        rw = asset_pack_rw(a->pack, (const char *)name->data);
+        bdestroy(name);
+    }
+
+    if(rw)
+        return img_load_surface_rw(rw);
+
+    name = bformat("%s/%05d", a->path, frame);
+    s = img_load_surface((const char *)name->data);
+    bdestroy(name);
+
+    return s;
+}
+
+static bool frame_exists(struct anim_bg *a, int frame)
+{
+    struct stat st;
+    bstring name = NULL;
+    bool found = false;
+
+    if(a->pack_name)
+    {
+        name = bformat("%s/%05d", a->pack_name, frame);
+        found = asset_pack_find(a->pack, (const char *)name->data) != NULL;
+        bdestroy(name);
+
+        if(found)
+            return true;
+    }
+
+    name = bformat("%s/%05d.png", a->path, frame);
+    found = stat((const char *)name->data, &st) == 0;
+    bdestroy(name);
+
+    if(!found)
+    {
+        name = bformat("%s/%05d.jpg", a->path, frame);
+        found = stat((const char *)name->data, &st) == 0;
+        bdestroy(name);
+    }
+
+    return found;
+}
+
+// copies src into the slot's surface, converting and clipping as needed; frees src
+static bool fill_slot(struct anim_bg_slot *slot, SDL_Surface *src)
+{
+    bool ok = false;
+
+    if(!src)
+        return false;
+
+    SDL_SetSurfaceBlendMode(src, SDL_BLENDMODE_NONE);
+    ok = SDL_BlitSurface(src, NULL, slot->surface, NULL) == 0;
+    SDL_FreeSurface(src);
+
+    return ok;
+}
+
+// whatever ring of textures the last background stopped with, for the next one of the same size
+static struct
+{
+    SDL_Texture *tex[ANIM_BG_RING];
+    int w;
+    int h;
+} spare;
+
+// frame 0 decides the ring's size, so the surfaces are only made once it's in
+static bool alloc_surfaces(struct anim_bg *a, SDL_Surface *first)
+{
+    int i = 0;
+
+    a->w = first->w;
+    a->h = first->h;
+
+    for(i = 0; i < ANIM_BG_RING; i++)
+    {
+        a->ring[i].surface = SDL_CreateRGBSurfaceWithFormat(0, a->w, a->h, 32, SDL_PIXELFORMAT_ARGB8888);
+        if(!a->ring[i].surface)
+        {
+            log_err("Animated background %s: %s\n", a->path, SDL_GetError());
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static void give_back_textures(struct anim_bg *a)
+{
+    int i = 0;
+
+    if(!a->ring[0].tex)
+        return;
+
+    anim_bg_free_textures();
+
+    for(i = 0; i < ANIM_BG_RING; i++)
+    {
+        spare.tex[i] = a->ring[i].tex;
+        a->ring[i].tex = NULL;
+    }
+
+    spare.w = a->w;
+    spare.h = a->h;
+}
+
+// on the render thread, when the first frame is about to go up
+static bool take_textures(struct anim_bg *a, SDL_Renderer *renderer)
+{
+    int i = 0;
+
+    if(spare.w != a->w || spare.h != a->h)
+        anim_bg_free_textures();
+
+    for(i = 0; i < ANIM_BG_RING; i++)
+    {
+        a->ring[i].tex = spare.tex[i];
+        spare.tex[i] = NULL;
+
+        if(!a->ring[i].tex)
+            a->ring[i].tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, a->w, a->h);
+
+        if(!a->ring[i].tex)
+        {
+            log_err("Animated background %s: %s\n", a->path, SDL_GetError());
+            give_back_textures(a);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static int decode_thread(void *data)
+{
+    struct anim_bg *a = (struct anim_bg *)data;
+    struct anim_bg_slot *slot = NULL;
+    SDL_Surface *src = NULL;
+    unsigned int seq = 0;
+    int frame = 0;
+    bool ok = false;
+
+    for(;; seq++)
+    {
+        slot = &a->ring[seq % ANIM_BG_RING];
+
+        SDL_LockMutex(a->lock);
+        while(!a->quit && slot->state != ANIM_BG_SLOT_FREE)
+            SDL_CondWait(a->cond, a->lock);
+        SDL_UnlockMutex(a->lock);
+
+        if(a->quit)
+            break;
+
+        // the slot is ours until it's marked decoded, so this happens outside the lock
+        frame = seq % a->num_frames;
+        src = load_frame(a, frame);
+
+        if(!seq && src && !alloc_surfaces(a, src))
+        {
+            SDL_FreeSurface(src);
+            src = NULL;
+        }
+
+        ok = fill_slot(slot, src);
+        if(!ok)
+            log_err("Animated background %s: can't load frame %d\n", a->path, frame);
+
+        SDL_LockMutex(a->lock);
+        slot->ok = ok;
+        slot->state = ANIM_BG_SLOT_DECODED;
+        SDL_UnlockMutex(a->lock);
+
+        // nothing to play without frame 0; the main thread sees the failed slot and shows bg instead
+        if(!seq && !ok)
+            break;
+    }
+
+    return 0;
+}
+
+struct anim_bg *anim_bg_create(const char *path, const char *pack_name, struct asset_pack *pack, int frame_multiplier)
+{
+    if(!path)
+        return NULL;
+
+    struct anim_bg *a = (struct anim_bg *)malloc(sizeof(struct anim_bg));
+    int i = 0;
+
+    a->path = (char *)malloc(strlen(path) + 1);
+    strcpy(a->path, path);
+    a->pack_name = NULL;
+    if(pack_name && pack)
+    {
+        a->pack_name = (char *)malloc(strlen(pack_name) + 1);
+        strcpy(a->pack_name, pack_name);
+    }
+    a->pack = pack;
+
+    a->frame_multiplier = frame_multiplier > 0 ? frame_multiplier : 1;
+    a->counter = 0;
+
+    for(i = 0; i < ANIM_BG_RING; i++)
+    {
+        a->ring[i].state = ANIM_BG_SLOT_FREE;
+        a->ring[i].ok = false;
+        a->ring[i].surface = NULL;
+        a->ring[i].tex = NULL;
+    }
+
+    a->w = 0;
+    a->h = 0;
+    a->current = NULL;
+    a->next = 0;
+
+    a->thread = NULL;
+    a->lock = NULL;
+    a->cond = NULL;
+    a->quit = false;
+
+    // only the names are looked at here; nothing is decoded until the background is started
+    for(i = 0; i < ANIM_BG_MAX_FRAMES; i++)
+    {
+        if(!frame_exists(a, i))
+            break;
+    }
+
+    a->num_frames = i;
+
+    if(!a->num_frames)
+    {
+        anim_bg_destroy(a);
+        return NULL;
+    }
+
+    log_info("Animated background %s: %d frames\n", path, a->num_frames);
+    return a;
+}
+
+void anim_bg_destroy(struct anim_bg *a)
+{
+    if(!a)
+        return;
+
+    anim_bg_stop(a);
+
+    free(a->path);
+    free(a->pack_name);
+    free(a);
+}
+
+int anim_bg_start(struct anim_bg *a)
+{
+    if(!a)
+        return -1;
+
+    if(a->thread)
+        return 0;
+
+    a->counter = 0;
+    a->next = 0;
+    a->current = NULL;
+    a->quit = false;
+
+    a->lock = SDL_CreateMutex();
+    a->cond = SDL_CreateCond();
+    a->thread = SDL_CreateThread(decode_thread, "anim_bg", a);
+
+    if(!a->thread)
+    {
+        log_err("SDL_CreateThread: %s\n", SDL_GetError());
+        anim_bg_stop(a);
+        return 1;
+    }
+
+    return 0;
+}
+
+bool anim_bg_ready(struct anim_bg *a)
+{
+    bool ready = false;
+
+    if(!a || !a->thread)
+        return false;
+
+    if(a->next)
+        return true;
+
+    SDL_LockMutex(a->lock);
+    ready = a->ring[0].state == ANIM_BG_SLOT_DECODED;
+    SDL_UnlockMutex(a->lock);
+
+    return ready;
+}
+
+void anim_bg_stop(struct anim_bg *a)
+{
+    if(!a)
+        return;
+
+    int i = 0;
+
+    if(a->thread)
+    {
+        SDL_LockMutex(a->lock);
+        a->quit = true;
+        SDL_CondSignal(a->cond);
+        SDL_UnlockMutex(a->lock);
+
+        SDL_WaitThread(a->thread, NULL);
+        a->thread = NULL;
+    }
+
+    if(a->cond)
+        SDL_DestroyCond(a->cond);
+    if(a->lock)
+        SDL_DestroyMutex(a->lock);
+    a->cond = NULL;
+    a->lock = NULL;
+
+    give_back_textures(a);
+
+    for(i = 0; i < ANIM_BG_RING; i++)
+    {
+        if(a->ring[i].surface)
+            SDL_FreeSurface(a->ring[i].surface);
+
+        a->ring[i].surface = NULL;
+        a->ring[i].state = ANIM_BG_SLOT_FREE;
+    }
+
+    a->current = NULL;
+}
+
+void anim_bg_free_textures()
+{
+    int i = 0;
+
+    for(i = 0; i < ANIM_BG_RING; i++)
+    {
+        if(spare.tex[i])
+            SDL_DestroyTexture(spare.tex[i]);
+        spare.tex[i] = NULL;
+    }
+
+    spare.w = 0;
+    spare.h = 0;
+}
+
+SDL_Texture *anim_bg_frame(struct anim_bg *a, SDL_Renderer *renderer)
+{
+    if(!a || !a->thread || !renderer)
+        return NULL;
+
+    struct anim_bg_slot *slot = &a->ring[a->next % ANIM_BG_RING];
+    bool ready = false;
+
+    if(a->current)
+    {
+        a->counter++;
+        if(a->counter < a->frame_multiplier)
+            return a->current;
+    }
+
+    SDL_LockMutex(a->lock);
+    ready = slot->state == ANIM_BG_SLOT_DECODED;
+    SDL_UnlockMutex(a->lock);
+
+    // the decoder fell behind: hold this frame rather than skip ahead
+    if(!ready)
+        return a->current;
+
+    // the ring's textures are only needed from the first frame on; if they can't be had, bg stays up
+    if(!a->next && slot->ok && !take_textures(a, renderer))
+        slot->ok = false;
+
+    /* each frame goes into its own slot's texture, so the one the last frame was drawn from isn't
+       rewritten while it may still be in use */
+    if(slot->ok && slot->tex)
+    {
+        SDL_UpdateTexture(slot->tex, NULL, slot->surface->pixels, slot->surface->pitch);
+        a->current = slot->tex;
+    }
+
+    a->next++;
+    a->counter = 0;
+
+    SDL_LockMutex(a->lock);
+    slot->state = ANIM_BG_SLOT_FREE;
+    SDL_CondSignal(a->cond);
+    SDL_UnlockMutex(a->lock);
+
+    return a->current;
+}
@@ -0,0 +1,66 @@
+#ifndef _anim_bg_h
+#define _anim_bg_h
+
+#include <SDL2/SDL.h>
+#include "asset_pack.h"
+
+#define ANIM_BG_MAX_FRAMES 1000
+#define ANIM_BG_RING 3    // frames decoded ahead of the one on screen
+
+enum anim_bg_slot_state
+{
+    ANIM_BG_SLOT_FREE,       // the decoder's to fill
+    ANIM_BG_SLOT_DECODED     // waiting for the main thread to upload it
+};
+
+struct anim_bg_slot
+{
+    int state;
+    bool ok;                 // false if the frame couldn't be decoded
+    SDL_Surface *surface;    // decoded frame, converted to the ring's format
+    SDL_Texture *tex;
+};
+
+/* an animated background, frames named <directory>/00000, 00001, ... like any other image. nothing is
+   kept in memory until it's started; then a worker thread decodes frames, frame 0 included, ahead into
+   a small ring of reusable surfaces and the main thread uploads each into its slot's texture as it
+   comes up, so an animation costs the same few frames of memory however long it is. the textures are
+   handed on to the next background of the same size when one stops, rather than made again */
+struct anim_bg
+{
+    char *path;         // loose files, without the frame number
+    char *pack_name;    // same within the pack, NULL to only use loose files
+    struct asset_pack *pack;
+
+    int num_frames;
+    int frame_multiplier;    // display frames per animation frame
+    int counter;
+
+    struct anim_bg_slot ring[ANIM_BG_RING];
+    int w;
+    int h;
+    SDL_Texture *current;    // what's on screen, NULL until frame 0 is up
+    unsigned int next;       // sequence number of the frame to show next
+
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    SDL_cond *cond;
+    bool quit;
+};
+
+// NULL if there's no frame 0
+struct anim_bg *anim_bg_create(const char *path, const char *pack_name, struct asset_pack *pack, int frame_multiplier);
+void anim_bg_destroy(struct anim_bg *a);
+
+// starts decoding from frame 0 and returns straight away; keep showing something else until anim_bg_ready()
+int anim_bg_start(struct anim_bg *a);
+bool anim_bg_ready(struct anim_bg *a);    // frame 0 is decoded, or failed to
+void anim_bg_stop(struct anim_bg *a);
+
+// advances the animation by one display frame; if the next frame isn't decoded yet, the current one is held
+SDL_Texture *anim_bg_frame(struct anim_bg *a, SDL_Renderer *renderer);
+
+// the textures kept for the next background; before the renderer goes
+void anim_bg_free_textures();
+
+#endif
@@ -0,0 +1,135 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "core.h"
+#include "asset_cache.h"
+#include "debug.h"
+
+struct asset_cache *asset_cache_create(unsigned long budget)
+{
+    struct asset_cache *c = (struct asset_cache *)malloc(sizeof(struct asset_cache));
+    int i = 0;
+
+    c->budget = budget;
+    c->bytes = 0;
+    c->loaded = ASSET_GROUP_BIT(ASSET_GROUP_COMMON);    // load_files() already took care of it
+    c->clock = 0;
+
+    for(i = 0; i < ASSET_GROUP_COUNT; i++)
+    {
+        c->pins[i] = 0;
+        c->group_bytes[i] = 0;
+        c->last_used[i] = 0;
+    }
+
+    return c;
+}
+
+void asset_cache_destroy(struct asset_cache *c)
+{
+    if(c)
+        free(c);
+}
+
+static void asset_cache_evict(coreState *cs, int group)
+{
+    struct asset_cache *c = cs->asset_cache;
+
+    log_debug("Evicting asset group %d (%lu bytes)\n", group, c->group_bytes[group]);
+
+    unload_asset_group(cs, group);
+
+    c->bytes -= c->group_bytes[group];
+    c->group_bytes[group] = 0;
+    c->loaded &= ~ASSET_GROUP_BIT(group);
+}
+
+int asset_cache_acquire(coreState *cs, unsigned int groups)
+{
+    if(!cs || !cs->asset_cache)
+        return -1;
+
+    struct asset_cache *c = cs->asset_cache;
+    int rc = 0;
+    int i = 0;
+
+    c->clock++;
+
+    for(i = 0; i < ASSET_GROUP_COUNT; i++)
+    {
+        if(!(groups & ASSET_GROUP_BIT(i)))
+            continue;
+
+        c->pins[i]++;
+        c->last_used[i] = c->clock;
+
+        if(c->loaded & ASSET_GROUP_BIT(i))
+            continue;
+
+        // whatever failed to load is left empty, same as at startup
+        if(load_asset_group(cs, i))
+            rc = 1;
+
+        c->loaded |= ASSET_GROUP_BIT(i);
+        c->group_bytes[i] = asset_group_bytes(cs, i);
+        c->bytes += c->group_bytes[i];
+    }
+
+    asset_cache_trim(cs, c->budget);
+
+    return rc;
+}
+
+void asset_cache_release(coreState *cs, unsigned int groups)
+{
+    if(!cs || !cs->asset_cache)
+        return;
+
+    struct asset_cache *c = cs->asset_cache;
+    int i = 0;
+
+    for(i = 0; i < ASSET_GROUP_COUNT; i++)
+    {
+        if(!(groups & ASSET_GROUP_BIT(i)) || !(c->loaded & ASSET_GROUP_BIT(i)))
+            continue;
+
+        if(c->pins[i] > 0)
+            c->pins[i]--;
+
+        // prefetched music may have grown the group while it was in use
+        c->bytes -= c->group_bytes[i];
+        c->group_bytes[i] = asset_group_bytes(cs, i);
+        c->bytes += c->group_bytes[i];
+    }
+
+    asset_cache_trim(cs, c->budget);
+}
+
+void asset_cache_trim(coreState *cs, unsigned long bytes)
+{
+    if(!cs || !cs->asset_cache)
+        return;
+
+    struct asset_cache *c = cs->asset_cache;
+    int oldest = -1;
+    int i = 0;
+
+    while(c->bytes > bytes)
+    {
+        oldest = -1;
+
+        for(i = 0; i < ASSET_GROUP_COUNT; i++)
+        {
+            if(!(c->loaded & ASSET_GROUP_BIT(i)) || c->pins[i] || i == ASSET_GROUP_COMMON)
+                continue;
+
+            if(oldest < 0 || c->last_used[i] < c->last_used[oldest])
+                oldest = i;
+        }
+
+        if(oldest < 0)
+            break;
+
+        asset_cache_evict(cs, oldest);
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef _asset_cache_h
+#define _asset_cache_h
+
+#include "core.h"
+
+// every image and music track belongs to one of these (third column of images.h and music.h)
+enum asset_group
+{
+    ASSET_GROUP_COMMON,    // menus, fonts, pieces, sfx: loaded by load_files() and never evicted
+    ASSET_GROUP_BACKGROUNDS,
+    ASSET_GROUP_PENTOMINO,
+    ASSET_GROUP_G1,
+    ASSET_GROUP_G2,    // music shared by G2 master and death
+    ASSET_GROUP_G2_MASTER,
+    ASSET_GROUP_G2_DEATH,
+    ASSET_GROUP_G3,
+    ASSET_GROUP_COUNT
+};
+
+#define ASSET_GROUP_BIT(group) (1u << (group))
+
+// bytes of textures and music that may stay loaded once nothing is using them
+#define ASSET_CACHE_BUDGET (32ul * 1024ul * 1024ul)
+
+/* mode assets are loaded when a game first needs them and then kept around, least recently used
+   first out, until they no longer fit the budget or the OS reports low memory. groups in use by
+   the running game are pinned and never evicted, which may put the cache over budget for a while */
+struct asset_cache
+{
+    unsigned long budget;
+    unsigned long bytes;    // total of group_bytes[]
+
+    unsigned int loaded;    // ASSET_GROUP_BIT()s
+    int pins[ASSET_GROUP_COUNT];
+    unsigned long group_bytes[ASSET_GROUP_COUNT];
+    unsigned long last_used[ASSET_GROUP_COUNT];
+    unsigned long clock;
+};
+
+struct asset_cache *asset_cache_create(unsigned long budget);
+void asset_cache_destroy(struct asset_cache *c);
+
+// loads whichever of groups are not loaded yet and pins all of them until asset_cache_release()
+int asset_cache_acquire(coreState *cs, unsigned int groups);
+void asset_cache_release(coreState *cs, unsigned int groups);
+
+// evicts unpinned groups, least recently used first, until no more than bytes are loaded
+void asset_cache_trim(coreState *cs, unsigned long bytes);
+
+#endif
@@ -0,0 +1,239 @@
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+
+#include "core.h"
+#include "asset_loader.h"
+#include "audio.h"
+#include "debug.h"
+#include "gfx_structures.h"
+
+struct asset_loader *asset_loader_create(int max_jobs)
+{
+    struct asset_loader *l = (struct asset_loader *)malloc(sizeof(struct asset_loader));
+
+    l->jobs = (struct asset_job *)malloc(max_jobs * sizeof(struct asset_job));
+    l->num_jobs = 0;
+    l->max_jobs = max_jobs;
+
+    SDL_AtomicSet(&l->next_job, 0);
+
+    l->lock = SDL_CreateMutex();
+    l->cond = SDL_CreateCond();
+    l->done_head = NULL;
+    l->done_tail = NULL;
+
+    l->num_threads = 0;
+
+    l->pack = NULL;
+
+    l->progress = NULL;
+    l->progress_data = NULL;
+
+    return l;
+}
+
+void asset_loader_destroy(struct asset_loader *l)
+{
+    if(!l)
+        return;
+
+    int i = 0;
+
+    for(i = 0; i < l->num_jobs; i++)
+    {
+        free(l->jobs[i].path);
+        free(l->jobs[i].pack_name);
+        if(l->jobs[i].surface)
+            SDL_FreeSurface(l->jobs[i].surface);
+    }
+
+    SDL_DestroyCond(l->cond);
+    SDL_DestroyMutex(l->lock);
+    free(l->jobs);
+    free(l);
+}
+
+int asset_loader_add(struct asset_loader *l, int type, const char *name, const char *path, const char *pack_name,
+                     void *dest)
+{
+    if(!l || !path || !dest)
+        return -1;
+
+    if(l->num_jobs == l->max_jobs)
+        return 1;
+
+    struct asset_job *j = &l->jobs[l->num_jobs++];
+
+    j->type = type;
+    j->name = name;
+    j->path = (char *)malloc(strlen(path) + 1);
+    strcpy(j->path, path);
+    j->pack_name = NULL;
+    if(pack_name)
+    {
+        j->pack_name = (char *)malloc(strlen(pack_name) + 1);
+        strcpy(j->pack_name, pack_name);
+    }
+    j->dest = dest;
+
+    j->surface = NULL;
+    j->ok = false;
+    j->next_done = NULL;
+
+    return 0;
+}
+
+static void asset_job_decode(struct asset_loader *l, struct asset_job *j)
+{
+    SDL_RWops *rw = NULL;
+
+    // music keeps streaming from wherever it came from, so it opens its own
+    if(l->pack && j->pack_name && j->type != ASSET_MUSIC)
+        rw = asset_pack_rw(l->pack, j->pack_name);
+
+    switch(j->type)
+    {
+        case ASSET_IMAGE:
+            j->surface = rw ? img_load_surface_rw(rw) : img_load_surface(j->path);
+            j->ok = j->surface != NULL;
+            break;
+
+        // these only fill in their own struct, nothing the main thread is reading yet
+        case ASSET_MUSIC:
+            j->ok = (l->pack && j->pack_name && music_load_packed((struct music *)j->dest, l->pack, j->pack_name)) ||
+                    music_load((struct music *)j->dest, j->path);
+            break;
+
+        case ASSET_SFX:
+            j->ok = rw ? sfx_load_rw((struct sfx *)j->dest, rw) : sfx_load((struct sfx *)j->dest, j->path);
+            break;
+
+        default:
+            break;
+    }
+}
+
+static int asset_loader_thread(void *data)
+{
+    struct asset_loader *l = (struct asset_loader *)data;
+    struct asset_job *j = NULL;
+    int i = 0;
+
+    for(;;)
+    {
+        i = SDL_AtomicAdd(&l->next_job, 1);
+        if(i >= l->num_jobs)
+            break;
+
+        j = &l->jobs[i];
+        asset_job_decode(l, j);
+
+        SDL_LockMutex(l->lock);
+
+        if(l->done_tail)
+            l->done_tail->next_done = j;
+        else
+            l->done_head = j;
+        l->done_tail = j;
+
+        SDL_CondSignal(l->cond);
+        SDL_UnlockMutex(l->lock);
+    }
+
+    return 0;
+}
+
+static void asset_job_finish(coreState *cs, struct asset_job *j)
+{
+    if(j->type == ASSET_IMAGE)
+    {
+        j->ok = img_load_from_surface((gfx_image *)j->dest, j->surface, cs);
+        j->surface = NULL;
+    }
+
+    if(!j->ok)
+    {
+        switch(j->type)
+        {
+            case ASSET_IMAGE:
+                log_debug("Failed to load image '%s'\n", j->name);
+                break;
+            case ASSET_MUSIC:
+                log_debug("Failed to load music '%s'\n", j->name);
+                break;
+            case ASSET_SFX:
+                log_debug("Failed to load sfx '%s'\n", j->name);
+                break;
+            default:
+                break;
+        }
+    }
+}
+
+int asset_loader_run(coreState *cs, struct asset_loader *l)
+{
+    if(!cs || !l)
+        return -1;
+
+    SDL_Thread *threads[ASSET_LOADER_MAX_THREADS];
+    struct asset_job *j = NULL;
+    unsigned int num_threads = l->num_threads;
+    unsigned int num_started = 0;
+    unsigned int i = 0;
+    int done = 0;
+
+    if(num_threads == 0)
+        num_threads = SDL_GetCPUCount();
+    if(num_threads > ASSET_LOADER_MAX_THREADS)
+        num_threads = ASSET_LOADER_MAX_THREADS;
+    if(num_threads > (unsigned int)l->num_jobs)
+        num_threads = l->num_jobs;
+
+    for(i = 0; i < num_threads; i++)
+    {
+        threads[i] = SDL_CreateThread(asset_loader_thread, "asset_loader", l);
+        if(!threads[i])
+        {
+            log_err("SDL_CreateThread: %s\n", SDL_GetError());
+            break;
+        }
+
+        num_started++;
+    }
+
+    // without any workers everything is decoded right here, then finished below as usual
+    if(!num_started)
+        asset_loader_thread(l);
+
+    SDL_LockMutex(l->lock);
+
+    while(done < l->num_jobs)
+    {
+        while(!l->done_head)
+            SDL_CondWait(l->cond, l->lock);
+
+        j = l->done_head;
+        l->done_head = j->next_done;
+        if(!l->done_head)
+            l->done_tail = NULL;
+
+        SDL_UnlockMutex(l->lock);
+
+        asset_job_finish(cs, j);
+        done++;
+
+        if(l->progress)
+            l->progress(cs, done, l->num_jobs, l->progress_data);
+
+        SDL_LockMutex(l->lock);
+    }
+
+    SDL_UnlockMutex(l->lock);
+
+    for(i = 0; i < num_started; i++)
+        SDL_WaitThread(threads[i], NULL);
+
+    return 0;
+}
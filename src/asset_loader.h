@@ -0,0 +1,67 @@
+#ifndef _asset_loader_h
+#define _asset_loader_h
+
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_mixer.h>
+#include "core.h"
+#include "asset_pack.h"
+
+#define ASSET_LOADER_MAX_THREADS 8
+
+enum asset_type
+{
+    ASSET_IMAGE,
+    ASSET_MUSIC,
+    ASSET_SFX
+};
+
+struct asset_job
+{
+    int type;
+    const char *name;    // as listed in images.h/music.h/sfx.h, for messages
+    char *path;          // without extension
+    char *pack_name;     // key in the asset pack, NULL to always load path
+    void *dest;          // gfx_image *, struct music * or struct sfx *
+
+    SDL_Surface *surface;    // images are decoded by a worker but uploaded by the main thread
+    bool ok;
+
+    struct asset_job *next_done;
+};
+
+typedef void (*asset_progress_fn)(coreState *cs, int done, int total, void *data);
+
+/* decodes PNGs, WAVs and OGGs on worker threads while the main thread turns finished images into textures;
+   SDL_CreateTextureFromSurface() must stay on the thread that owns the renderer, everything else doesn't */
+struct asset_loader
+{
+    struct asset_job *jobs;
+    int num_jobs;
+    int max_jobs;
+
+    SDL_atomic_t next_job;
+
+    // finished jobs waiting for the main thread, oldest first
+    SDL_mutex *lock;
+    SDL_cond *cond;
+    struct asset_job *done_head;
+    struct asset_job *done_tail;
+
+    unsigned int num_threads;    // 0 for one per CPU
+
+    struct asset_pack *pack;    // tried before the loose files when set
+
+    asset_progress_fn progress;    // called on the main thread after each asset is done
+    void *progress_data;
+};
+
+struct asset_loader *asset_loader_create(int max_jobs);
+void asset_loader_destroy(struct asset_loader *l);
+
+int asset_loader_add(struct asset_loader *l, int type, const char *name, const char *path, const char *pack_name,
+                     void *dest);
+
+// returns once every asset has been loaded (or has failed to; failures are logged and leave dest empty)
+int asset_loader_run(coreState *cs, struct asset_loader *l);
+
+#endif
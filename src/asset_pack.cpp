@@ -0,0 +1,238 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+
+#include "asset_pack.h"
+#include "debug.h"
+
+// one asset's bytes within the pack
+struct asset_pack_window
+{
+    struct asset_pack *pack;
+    Sint64 offset;
+    Sint64 size;
+    Sint64 pos;
+};
+
+static Sint64 window_size(SDL_RWops *rw)
+{
+    struct asset_pack_window *w = (struct asset_pack_window *)rw->hidden.unknown.data1;
+    return w->size;
+}
+
+static Sint64 window_seek(SDL_RWops *rw, Sint64 offset, int whence)
+{
+    struct asset_pack_window *w = (struct asset_pack_window *)rw->hidden.unknown.data1;
+    Sint64 pos = 0;
+
+    switch(whence)
+    {
+        case RW_SEEK_SET:
+            pos = offset;
+            break;
+        case RW_SEEK_CUR:
+            pos = w->pos + offset;
+            break;
+        case RW_SEEK_END:
+            pos = w->size + offset;
+            break;
+        default:
+            return SDL_SetError("Unknown seek mode");
+    }
+
+    if(pos < 0)
+        pos = 0;
+    if(pos > w->size)
+        pos = w->size;
+
+    w->pos = pos;
+    return pos;
+}
+
+static size_t window_read(SDL_RWops *rw, void *ptr, size_t size, size_t maxnum)
+{
+    struct asset_pack_window *w = (struct asset_pack_window *)rw->hidden.unknown.data1;
+    size_t bytes = size * maxnum;
+    size_t n = 0;
+
+    if(!size)
+        return 0;
+
+    if((Sint64)bytes > w->size - w->pos)
+        bytes = (size_t)((w->size - w->pos) / (Sint64)size * (Sint64)size);
+
+    if(!bytes)
+        return 0;
+
+    SDL_LockMutex(w->pack->lock);
+
+    if(SDL_RWseek(w->pack->file, w->offset + w->pos, RW_SEEK_SET) >= 0)
+        n = SDL_RWread(w->pack->file, ptr, 1, bytes);
+
+    SDL_UnlockMutex(w->pack->lock);
+
+    w->pos += n;
+    return n / size;
+}
+
+static size_t window_write(SDL_RWops *rw, const void *ptr, size_t size, size_t num)
+{
+    SDL_SetError("Asset pack is read-only");
+    return 0;
+}
+
+static int window_close(SDL_RWops *rw)
+{
+    if(rw)
+    {
+        free(rw->hidden.unknown.data1);
+        SDL_FreeRW(rw);
+    }
+
+    return 0;
+}
+
+static bool read_block(SDL_RWops *file, void *dest, size_t size)
+{
+    return !size || SDL_RWread(file, dest, size, 1) == 1;
+}
+
+struct asset_pack *asset_pack_open(const char *path)
+{
+    if(!path)
+        return NULL;
+
+    SDL_RWops *file = SDL_RWFromFile(path, "rb");
+    struct asset_pack *p = NULL;
+    struct asset_pack_header *h = NULL;
+    Sint64 file_size = 0;
+    uint32_t i = 0;
+
+    if(!file)
+        return NULL;
+
+    p = (struct asset_pack *)malloc(sizeof(struct asset_pack));
+    p->file = file;
+    p->lock = NULL;
+    p->buckets = NULL;
+    p->entries = NULL;
+    p->names = NULL;
+
+    h = &p->header;
+    file_size = SDL_RWsize(file);
+
+    if(!read_block(file, h, sizeof(struct asset_pack_header)) || memcmp(h->magic, ASSET_PACK_MAGIC, 8) ||
+       h->version != ASSET_PACK_VERSION || !h->num_buckets || (h->num_buckets & (h->num_buckets - 1)))
+    {
+        log_err("%s is not an asset pack this build can read\n", path);
+        goto error;
+    }
+
+    p->buckets = (uint32_t *)malloc(h->num_buckets * sizeof(uint32_t));
+    p->entries = (struct asset_pack_entry *)malloc((h->num_entries ? h->num_entries : 1) * sizeof(struct asset_pack_entry));
+    p->names = (char *)malloc(h->names_size ? h->names_size : 1);
+
+    if(!read_block(file, p->buckets, h->num_buckets * sizeof(uint32_t)) ||
+       !read_block(file, p->entries, h->num_entries * sizeof(struct asset_pack_entry)) ||
+       !read_block(file, p->names, h->names_size))
+    {
+        log_err("%s is truncated\n", path);
+        goto error;
+    }
+
+    for(i = 0; i < h->num_buckets; i++)
+    {
+        if(p->buckets[i] != ASSET_PACK_NONE && p->buckets[i] >= h->num_entries)
+            goto corrupt;
+    }
+
+    for(i = 0; i < h->num_entries; i++)
+    {
+        struct asset_pack_entry *e = &p->entries[i];
+
+        if((e->next != ASSET_PACK_NONE && e->next >= h->num_entries) ||
+           (uint64_t)e->name_offset + e->name_len > h->names_size || (Sint64)e->offset + e->size > file_size)
+            goto corrupt;
+    }
+
+    p->lock = SDL_CreateMutex();
+
+    log_info("Using asset pack %s (%u files)\n", path, h->num_entries);
+    return p;
+
+corrupt:
+    log_err("%s is corrupt\n", path);
+
+error:
+    asset_pack_close(p);
+    return NULL;
+}
+
+void asset_pack_close(struct asset_pack *p)
+{
+    if(!p)
+        return;
+
+    if(p->lock)
+        SDL_DestroyMutex(p->lock);
+
+    SDL_RWclose(p->file);
+    free(p->buckets);
+    free(p->entries);
+    free(p->names);
+    free(p);
+}
+
+const struct asset_pack_entry *asset_pack_find(struct asset_pack *p, const char *name)
+{
+    if(!p || !name)
+        return NULL;
+
+    uint32_t len = strlen(name);
+    uint32_t hash = asset_pack_hash(name, len);
+    uint32_t i = p->buckets[hash & (p->header.num_buckets - 1)];
+    uint32_t steps = 0;
+    struct asset_pack_entry *e = NULL;
+
+    // the step limit only matters for a pack whose chains loop back on themselves
+    for(; i != ASSET_PACK_NONE && steps < p->header.num_entries; i = e->next, steps++)
+    {
+        e = &p->entries[i];
+
+        if(e->hash == hash && e->name_len == len && !memcmp(p->names + e->name_offset, name, len))
+            return e;
+    }
+
+    return NULL;
+}
+
+SDL_RWops *asset_pack_rw(struct asset_pack *p, const char *name)
+{
+    const struct asset_pack_entry *e = asset_pack_find(p, name);
+    struct asset_pack_window *w = NULL;
+    SDL_RWops *rw = NULL;
+
+    if(!e)
+        return NULL;
+
+    rw = SDL_AllocRW();
+    if(!rw)
+        return NULL;
+
+    w = (struct asset_pack_window *)malloc(sizeof(struct asset_pack_window));
+    w->pack = p;
+    w->offset = e->offset;
+    w->size = e->size;
+    w->pos = 0;
+
+    rw->size = window_size;
+    rw->seek = window_seek;
+    rw->read = window_read;
+    rw->write = window_write;
+    rw->close = window_close;
+    rw->type = SDL_RWOPS_UNKNOWN;
+    rw->hidden.unknown.data1 = w;
+
+    return rw;
+}
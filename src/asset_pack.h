@@ -0,0 +1,86 @@
+#ifndef _asset_pack_h
+#define _asset_pack_h
+
+#include <stdint.h>
+
+/* assets.pak, written by tools/mkassetpack.cpp from everything under gfx/ and audio/:
+
+       struct asset_pack_header
+       uint32_t buckets[num_buckets]            first entry in each hash chain, ASSET_PACK_NONE if empty
+       struct asset_pack_entry entries[num_entries]
+       char names[]                             entry names, not NUL-terminated
+       file data
+
+   entries are keyed by their path without extension ("gfx/bg0", "audio/track0"), which is how the
+   game asks for them; SDL_image and SDL_mixer tell the formats apart by content, so nothing has to
+   guess at extensions. all fields are little endian, offsets are from the start of the file */
+
+#define ASSET_PACK_MAGIC "SHIROPAK"
+#define ASSET_PACK_VERSION 1
+#define ASSET_PACK_NONE 0xffffffffu
+
+struct asset_pack_header
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t num_buckets;    // a power of two
+    uint32_t num_entries;
+    uint32_t names_size;
+};
+
+struct asset_pack_entry
+{
+    uint32_t hash;
+    uint32_t next;    // next entry in the same bucket
+    uint32_t name_offset;    // into names[]
+    uint32_t name_len;
+    uint32_t offset;
+    uint32_t size;
+};
+
+// FNV-1a
+static inline uint32_t asset_pack_hash(const char *name, uint32_t len)
+{
+    uint32_t h = 0x811c9dc5u;
+    uint32_t i = 0;
+
+    for(i = 0; i < len; i++)
+    {
+        h ^= (uint8_t)name[i];
+        h *= 0x01000193u;
+    }
+
+    return h;
+}
+
+#ifndef ASSET_PACK_FORMAT_ONLY
+
+struct SDL_RWops;
+struct SDL_mutex;
+
+/* the whole index is read up front and the pack stays open for as long as anything is loaded from
+   it; there's no mmap() on the Vita, so each asset is handed out as a read-only window onto the one
+   open file instead. windows share that file through a lock and may be read from any thread */
+struct asset_pack
+{
+    struct SDL_RWops *file;
+    struct SDL_mutex *lock;
+
+    struct asset_pack_header header;
+    uint32_t *buckets;
+    struct asset_pack_entry *entries;
+    char *names;
+};
+
+// NULL when there's no pack at path (or it can't be used), in which case loose files are loaded instead
+struct asset_pack *asset_pack_open(const char *path);
+void asset_pack_close(struct asset_pack *p);
+
+const struct asset_pack_entry *asset_pack_find(struct asset_pack *p, const char *name);
+
+// NULL if name is not in the pack; SDL_RWclose() it (or pass freesrc) when done
+struct SDL_RWops *asset_pack_rw(struct asset_pack *p, const char *name);
+
+#endif
+
+#endif
@@ -5,9 +5,11 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 #include <SDL2/SDL_mixer.h>
 
 #include "core.h"
+#include "asset_pack.h"
 #include "audio.h"
 #include "debug.h"
 
@@ -20,52 +22,190 @@ static void play_track(coreState *cs, Mix_Music *m, int volume)
     Mix_PlayMusic(m, -1);
 }
 
-static void play_sfx(Mix_Chunk *c, int volume)
+static void music_set_source(struct music *m, struct asset_pack *pack, const char *source)
 {
-    if(!c)
-        return;
-
-    // Mix_VolumeChunk(c, lrintf(((float)(nz->settings->sfx_volume) / 100.0) * 128.0));
-    Mix_VolumeChunk(c, volume);
-    if(Mix_PlayChannel(-1, c, 0) < 0)
-        log_err("Mix_PlayChannel() error: %s\n", Mix_GetError());
+    m->pack = pack;
+    m->source = (char *)malloc(strlen(source) + 1);
+    strcpy(m->source, source);
 }
 
 bool music_load(struct music *m, const char *path_without_ext)
 {
     m->data = NULL;
     m->volume = MIX_MAX_VOLUME;
+    m->pack = NULL;
+    m->source = NULL;
+    m->mem_size = 0;
 
     bstring path = bfromcstr(path_without_ext);
     bcatcstr(path, ".ogg");
     m->data = Mix_LoadMUS((const char *)(path->data));
-    bdestroy(path);
     if(m->data)
+    {
+        music_set_source(m, NULL, (const char *)(path->data));
+        bdestroy(path);
         return true;
+    }
+
+    bdestroy(path);
 
     path = bfromcstr(path_without_ext);
     bcatcstr(path, ".wav");
     m->data = Mix_LoadMUS((const char *)(path->data));
+    if(m->data)
+        music_set_source(m, NULL, (const char *)(path->data));
     bdestroy(path);
 
     return m->data != NULL;
 }
 
+// false if name isn't in the pack; the music streams from the pack for as long as it's loaded
+bool music_load_packed(struct music *m, struct asset_pack *pack, const char *name)
+{
+    SDL_RWops *rw = asset_pack_rw(pack, name);
+
+    m->data = NULL;
+    m->volume = MIX_MAX_VOLUME;
+    m->pack = NULL;
+    m->source = NULL;
+    m->mem_size = 0;
+
+    if(!rw)
+        return false;
+
+    m->data = Mix_LoadMUS_RW(rw, 1);
+    if(m->data)
+        music_set_source(m, pack, name);
+
+    return m->data != NULL;
+}
+
+static struct
+{
+    SDL_Thread *thread;
+    SDL_atomic_t done;
+
+    struct music *m;    // NULL when there's nothing being or been prefetched
+
+    Mix_Music *data;
+    unsigned long size;
+} prefetch = {NULL};
+
+// SDL_RWFromConstMem() leaves the buffer to its caller; this one's owned by the music loaded from it
+static int close_prefetch_buffer(SDL_RWops *rw)
+{
+    free((void *)rw->hidden.mem.base);
+    SDL_FreeRW(rw);
+    return 0;
+}
+
+static int music_prefetch_thread(void *data)
+{
+    struct music *m = (struct music *)data;
+    SDL_RWops *rw = m->pack ? asset_pack_rw(m->pack, m->source) : SDL_RWFromFile(m->source, "rb");
+    SDL_RWops *mem = NULL;
+    Sint64 size = rw ? SDL_RWsize(rw) : -1;
+    void *buf = NULL;
+
+    if(size > 0)
+        buf = malloc(size);
+
+    if(buf && SDL_RWread(rw, buf, size, 1) == 1)
+        mem = SDL_RWFromConstMem(buf, size);
+
+    if(rw)
+        SDL_RWclose(rw);
+
+    if(mem)
+    {
+        mem->close = close_prefetch_buffer;
+        prefetch.data = Mix_LoadMUS_RW(mem, 1);
+        prefetch.size = size;
+    }
+    else
+        free(buf);
+
+    SDL_AtomicSet(&prefetch.done, 1);
+    return 0;
+}
+
+void music_prefetch(struct music *m)
+{
+    if(!m || !m->data || !m->source || m->mem_size || prefetch.m == m)
+        return;
+
+    music_prefetch_cancel();
+
+    prefetch.m = m;
+    prefetch.data = NULL;
+    prefetch.size = 0;
+    SDL_AtomicSet(&prefetch.done, 0);
+
+    prefetch.thread = SDL_CreateThread(music_prefetch_thread, "music_prefetch", m);
+    if(!prefetch.thread)
+    {
+        log_err("SDL_CreateThread: %s\n", SDL_GetError());
+        prefetch.m = NULL;
+    }
+}
+
+void music_prefetch_cancel()
+{
+    if(!prefetch.m)
+        return;
+
+    SDL_WaitThread(prefetch.thread, NULL);
+
+    if(prefetch.data)
+        Mix_FreeMusic(prefetch.data);
+
+    prefetch.thread = NULL;
+    prefetch.m = NULL;
+    prefetch.data = NULL;
+}
+
 void music_play(struct music *m, coreState *cs)
 {
+    // hand over to the in-memory copy, unless it's still being read
+    if(prefetch.m == m && SDL_AtomicGet(&prefetch.done))
+    {
+        SDL_WaitThread(prefetch.thread, NULL);
+
+        if(prefetch.data)
+        {
+            Mix_FreeMusic(m->data);
+            m->data = prefetch.data;
+            m->mem_size = prefetch.size;
+        }
+
+        prefetch.thread = NULL;
+        prefetch.m = NULL;
+        prefetch.data = NULL;
+    }
+
     play_track(cs, m->data, m->volume);
 }
 
 void music_destroy(struct music *m)
 {
+    if(prefetch.m == m)
+        music_prefetch_cancel();
+
     if(m->data)
         Mix_FreeMusic(m->data);
+
+    free(m->source);
+
+    m->data = NULL;
+    m->source = NULL;
+    m->mem_size = 0;
 }
 
 bool sfx_load(struct sfx *s, const char *path_without_ext)
 {
     s->data = NULL;
     s->volume = MIX_MAX_VOLUME;
+    s->priority = 0;
 
     bstring path = bfromcstr(path_without_ext);
     bcatcstr(path, ".wav");
@@ -75,13 +215,123 @@ bool sfx_load(struct sfx *s, const char *path_without_ext)
     return s->data != NULL;
 }
 
-void sfx_play(struct sfx *s)
+bool sfx_load_rw(struct sfx *s, SDL_RWops *rw)
 {
-    play_sfx(s->data, s->volume);
+    s->volume = MIX_MAX_VOLUME;
+    s->priority = 0;
+    s->data = Mix_LoadWAV_RW(rw, 1);
+
+    return s->data != NULL;
 }
 
+static struct
+{
+    struct sfx *queue[SFX_QUEUE_MAX];
+    int num_queued;
+
+    int channel_priority[SFX_CHANNELS];    // of whatever each channel was last started with
+} sfx_mixer = {{NULL}};
+
 void sfx_destroy(struct sfx *s)
 {
+    int i = 0;
+
+    for(i = 0; i < sfx_mixer.num_queued; i++)
+    {
+        if(sfx_mixer.queue[i] == s)
+        {
+            sfx_mixer.num_queued--;
+            sfx_mixer.queue[i] = sfx_mixer.queue[sfx_mixer.num_queued];
+            break;
+        }
+    }
+
     if(s->data)
         Mix_FreeChunk(s->data);
+
+    s->data = NULL;
+}
+
+void sfx_play(struct sfx *s)
+{
+    int lowest = -1;
+    int i = 0;
+
+    if(!s || !s->data)
+        return;
+
+    for(i = 0; i < sfx_mixer.num_queued; i++)
+    {
+        if(sfx_mixer.queue[i] == s)
+            return;
+
+        if(lowest < 0 || sfx_mixer.queue[i]->priority < sfx_mixer.queue[lowest]->priority)
+            lowest = i;
+    }
+
+    if(sfx_mixer.num_queued < SFX_QUEUE_MAX)
+        sfx_mixer.queue[sfx_mixer.num_queued++] = s;
+    else if(s->priority > sfx_mixer.queue[lowest]->priority)
+        sfx_mixer.queue[lowest] = s;
+}
+
+// a free channel, or else the one playing the least important sound if that's below priority
+static int sfx_channel(int priority)
+{
+    int ch = Mix_GroupAvailable(-1);
+    int i = 0;
+
+    if(ch >= 0)
+        return ch;
+
+    for(i = 0; i < SFX_CHANNELS; i++)
+    {
+        if(ch < 0 || sfx_mixer.channel_priority[i] < sfx_mixer.channel_priority[ch])
+            ch = i;
+    }
+
+    if(ch < 0 || sfx_mixer.channel_priority[ch] >= priority)
+        return -1;
+
+    Mix_HaltChannel(ch);
+    return ch;
+}
+
+void sfx_queue_flush(coreState *cs)
+{
+    struct sfx *s = NULL;
+    int volume = (cs->sfx_volume * cs->master_volume) / 100;
+    int ch = 0;
+    int i = 0;
+    int j = 0;
+
+    // a handful at most, so insertion sort; ties keep the order they were queued in
+    for(i = 1; i < sfx_mixer.num_queued; i++)
+    {
+        s = sfx_mixer.queue[i];
+
+        for(j = i; j > 0 && sfx_mixer.queue[j - 1]->priority < s->priority; j--)
+            sfx_mixer.queue[j] = sfx_mixer.queue[j - 1];
+
+        sfx_mixer.queue[j] = s;
+    }
+
+    for(i = 0; i < sfx_mixer.num_queued && i < SFX_VOICES_PER_FRAME; i++)
+    {
+        s = sfx_mixer.queue[i];
+
+        ch = sfx_channel(s->priority);
+        if(ch < 0)
+            continue;
+
+        // the volume belongs to the channel, so the chunk itself is never touched
+        Mix_Volume(ch, (s->volume * volume) / MIX_MAX_VOLUME);
+
+        if(Mix_PlayChannel(ch, s->data, 0) < 0)
+            log_err("Mix_PlayChannel() error: %s\n", Mix_GetError());
+        else
+            sfx_mixer.channel_priority[ch] = s->priority;
+    }
+
+    sfx_mixer.num_queued = 0;
 }
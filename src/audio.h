@@ -9,21 +9,44 @@ struct music
 {
     Mix_Music *data;
     int volume;
+
+    // where data streams from, so music_prefetch() can read the track in again
+    struct asset_pack *pack;    // NULL for a loose file
+    char *source;               // entry name in pack, or the file's path
+    unsigned long mem_size;     // the whole track is held in memory once prefetched, 0 until then
 };
 
 bool music_load(struct music *m, const char *path_without_ext);
+bool music_load_packed(struct music *m, struct asset_pack *pack, const char *name);
 void music_play(struct music *m, coreState *cs);
 void music_destroy(struct music *m);
 
+/* reads m into memory on another thread, so that starting it later doesn't wait on storage; the next
+   music_play(m) switches over to the copy if it's ready by then and streams as usual if not. there's only
+   one prefetch at a time, and m must stay loaded until it's played or music_prefetch_cancel() is called */
+void music_prefetch(struct music *m);
+void music_prefetch_cancel();
+
 // class Sfx
 struct sfx
 {
     Mix_Chunk *data;
     int volume;
+    int priority;
 };
 
+#define SFX_CHANNELS 32
+#define SFX_QUEUE_MAX 16
+#define SFX_VOICES_PER_FRAME 6    // new sounds started per presented frame, highest priority first
+
 bool sfx_load(struct sfx *s, const char *path_without_ext);
-void sfx_play(struct sfx *s);
+bool sfx_load_rw(struct sfx *s, SDL_RWops *rw);
 void sfx_destroy(struct sfx *s);
 
+/* queues s to start when the frame is presented; the same sound queued more than once in between
+   only plays once. sounds that don't fit SFX_VOICES_PER_FRAME, or find every channel busy with
+   something more important, are dropped */
+void sfx_play(struct sfx *s);
+void sfx_queue_flush(coreState *cs);
+
 #endif
@@ -0,0 +1,296 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "bot.h"
+#include "core.h"
+#include "debug.h"
+#include "game_qs.h"
+#include "placement.h"
+#include "qrs.h"
+#include "replay.h"
+
+struct bot *bot_create(bot_evaluator evaluate, void *eval_data)
+{
+    struct bot *b = (struct bot *)malloc(sizeof(struct bot));
+
+    b->search = placement_search_create();
+    b->evaluate = evaluate ? evaluate : bot_evaluate_default;
+    b->eval_data = eval_data;
+
+    b->have_target = false;
+    b->was_active = false;
+    b->keys = (struct keyflags){0};
+
+    b->game = NULL;
+    b->game_frame = 0;
+    b->game_flags = 0;
+    b->game_level = 0;
+
+    b->restart = true;
+    b->restart_pending = false;
+    b->games = 0;
+
+    return b;
+}
+
+void bot_destroy(struct bot *b)
+{
+    if(!b)
+        return;
+
+    placement_search_destroy(b->search);
+    free(b);
+}
+
+int bot_evaluate_default(game_t *g, struct placement *pl, void *data)
+{
+    qrsdata *q = (qrsdata *)g->data;
+    int added[QRS_FIELD_H];
+    int lines = 0;
+    int holes = 0;
+    int depth = 0;
+    int height = 0;
+    int x = 0;
+    int y = 0;
+    int i = 0;
+    int j = 0;
+    bool covered = false;
+
+    for(i = 0; i < QRS_FIELD_H; i++)
+        added[i] = 0;
+
+    for(i = 0; i < pl->num_cells; i++)
+    {
+        x = pl->cells[i] % QRS_FIELD_W;
+        y = pl->cells[i] / QRS_FIELD_W;
+
+        added[y]++;
+        depth += y;
+
+        if(QRS_FIELD_H - y > height)
+            height = QRS_FIELD_H - y;
+
+        if(y + 1 >= QRS_FIELD_H || gridgetcell(g->field, x, y + 1))
+            continue;
+
+        covered = false;
+        for(j = 0; j < pl->num_cells; j++)
+        {
+            if(pl->cells[j] == pl->cells[i] + QRS_FIELD_W)
+                covered = true;
+        }
+
+        if(!covered)
+            holes++;
+    }
+
+    for(i = 0; i < QRS_FIELD_H; i++)
+    {
+        if(added[i] && q->field_counts.row_cells[i] + added[i] == q->field_w)
+            lines++;
+    }
+
+    for(i = 0; i < QRS_FIELD_W; i++)
+    {
+        if(gridgetcell(g->field, i, QRS_FIELD_H - 1) != QRS_WALL && QRS_FIELD_H - q->field_tops[i] > height)
+            height = QRS_FIELD_H - q->field_tops[i];
+    }
+
+    return lines * 100 - holes * 80 - height * 10 + depth * 4;
+}
+
+static struct placement *bot_choose(game_t *g, struct bot *b)
+{
+    struct placement *best = NULL;
+    int best_score = 0;
+    int score = 0;
+    int i = 0;
+
+    for(i = 0; i < b->search->num_placements; i++)
+    {
+        score = b->evaluate(g, &b->search->placements[i], b->eval_data);
+        if(!best || score > best_score)
+        {
+            best = &b->search->placements[i];
+            best_score = score;
+        }
+    }
+
+    return best;
+}
+
+static struct placement *bot_find_target(struct bot *b)
+{
+    struct placement *pl = NULL;
+    int i = 0;
+
+    for(i = 0; i < b->search->num_placements; i++)
+    {
+        pl = &b->search->placements[i];
+        if(pl->num_cells == b->target.num_cells && !memcmp(pl->cells, b->target.cells, pl->num_cells * sizeof(int)))
+            return pl;
+    }
+
+    return NULL;
+}
+
+static void bot_restart(coreState *cs, struct bot *b)
+{
+    b->restart_pending = false;
+
+    cs->p1game = qs_game_create(cs, b->game_level, b->game_flags, NO_REPLAY);
+    if(cs->p1game)
+    {
+        cs->p1game->init(cs->p1game);
+        log_debug("bot: starting game %lu\n", b->games + 1);
+    }
+}
+
+int bot_update(coreState *cs, struct bot *b)
+{
+    if(!cs || !b)
+        return -1;
+
+    game_t *g = cs->p1game;
+    qrsdata *q = NULL;
+    qrs_player *p = NULL;
+    struct placement *pl = NULL;
+    struct keyflags k = (struct keyflags){0};
+    bool active = false;
+
+    if(!g)
+    {
+        b->game = NULL;
+        if(b->restart_pending)
+            bot_restart(cs, b);
+
+        return 0;
+    }
+
+    q = (qrsdata *)g->data;
+    p = q->p1;
+
+    if(g != b->game || g->frame_counter < b->game_frame)
+    {
+        b->game = g;
+        b->game_flags = q->mode_flags;
+        b->game_level = q->level;
+        b->have_target = false;
+        b->was_active = false;
+        b->games++;
+    }
+
+    b->game_frame = g->frame_counter;
+
+    // replays drive the keys themselves, and a paused practice game belongs to the player
+    if(q->playback || cs->menu_input_override || (q->pracdata && q->pracdata->paused))
+        return 0;
+
+    if(q->state_flags & GAMESTATE_GAMEOVER)
+    {
+        // escape ends the game like it would for a player; practice games would just pause instead
+        if(!q->pracdata && !b->keys.escape)
+        {
+            k.escape = 1;
+            b->restart_pending = b->restart;
+        }
+
+        goto apply;
+    }
+
+    active = (p->state & (PSFALL | PSLOCK)) && !(p->state & PSPRELOCKED);
+
+    if(!active)
+    {
+        if(b->was_active)
+            b->have_target = false;
+        b->was_active = false;
+
+        // plan the next piece once the field is final: after the drop in line ARE, after rising garbage in ARE
+        if(!b->have_target && q->previews[0] && p->speeds &&
+           ((p->state & PSARE && q->p1counters->are >= 1) || p->state & PSLINEARE))
+        {
+            placement_enumerate(g, b->search, q->previews[0]->qrs_id, p->speeds->grav);
+            pl = bot_choose(g, b);
+            if(pl)
+            {
+                b->target = *pl;
+                b->have_target = true;
+            }
+        }
+
+        // IRS is read from the keys held when the piece spawns
+        if(b->have_target && b->target.num_inputs)
+        {
+            switch(b->target.inputs[0])
+            {
+                case PLACEMENT_IRS_CW:
+                    k.b = 1;
+                    break;
+                case PLACEMENT_IRS_CCW:
+                    k.a = 1;
+                    break;
+                case PLACEMENT_IRS_FLIP:
+                    k.d = 1;
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        goto apply;
+    }
+
+    b->was_active = true;
+
+    // rotations and shifts act on presses, so every one needs a frame with the key released first
+    if(b->keys.a || b->keys.b || b->keys.c || b->keys.d || b->keys.left || b->keys.right)
+        goto apply;
+
+    // replan from where the piece actually is; gravity and kicks may have moved it off the old path
+    placement_enumerate_from(g, b->search, p, p->speeds->grav);
+
+    pl = b->have_target ? bot_find_target(b) : NULL;
+    if(!pl)
+    {
+        pl = bot_choose(g, b);
+        if(pl)
+        {
+            b->target = *pl;
+            b->have_target = true;
+        }
+    }
+
+    if(!pl || !pl->num_inputs)
+    {
+        k.down = 1;
+        goto apply;
+    }
+
+    switch(pl->inputs[0])
+    {
+        case PLACEMENT_LEFT:
+            k.left = 1;
+            break;
+        case PLACEMENT_RIGHT:
+            k.right = 1;
+            break;
+        case PLACEMENT_CW:
+            k.b = 1;
+            break;
+        case PLACEMENT_CCW:
+            k.a = 1;
+            break;
+        default:
+            k.down = 1;
+            break;
+    }
+
+apply:
+    b->keys = k;
+    cs->keys_raw = k;
+    cs->keys = k;
+
+    return 0;
+}
@@ -0,0 +1,44 @@
+#ifndef _bot_h
+#define _bot_h
+
+#include "core.h"
+#include "placement.h"
+
+// scores a placement of the current piece on g's field, higher is better
+typedef int (*bot_evaluator)(game_t *g, struct placement *pl, void *data);
+
+/* plays cs->p1game by writing cs->keys_raw/cs->keys each frame, so everything downstream
+   (qrs_input, DAS, replay recording) sees exactly what a player's controller would produce */
+struct bot
+{
+    struct placement_search *search;
+
+    bot_evaluator evaluate;
+    void *eval_data;
+
+    struct placement target;
+    bool have_target;
+    bool was_active;
+
+    struct keyflags keys; // what the bot held last frame
+
+    // game the bot is playing, so it can start another like it after a game over
+    game_t *game;
+    unsigned long game_frame;
+    unsigned int game_flags;
+    int game_level;
+
+    bool restart;
+    bool restart_pending;
+    unsigned long games;
+};
+
+struct bot *bot_create(bot_evaluator evaluate, void *eval_data);
+void bot_destroy(struct bot *b);
+
+// call once per frame after input events are read and before replays are recorded/played back
+int bot_update(coreState *cs, struct bot *b);
+
+int bot_evaluate_default(game_t *g, struct placement *pl, void *data);
+
+#endif
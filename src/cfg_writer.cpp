@@ -0,0 +1,168 @@
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+
+#include "core.h"
+#include "cfg_writer.h"
+#include "debug.h"
+#include "file_io.h"
+
+// only what write_cfg() saves, and nothing that points elsewhere
+static void copy_settings(struct settings *dest, struct bindings *dest_keybinds, const struct settings *src)
+{
+    *dest = *src;
+    *dest_keybinds = *src->keybinds;
+    dest->keybinds = dest_keybinds;
+    dest->home_path = NULL;
+    dest->player_name = NULL;
+    dest->seed_scan = NULL;
+}
+
+static bool settings_differ(const struct settings *a, const struct settings *b)
+{
+    return a->master_volume != b->master_volume || a->sfx_volume != b->sfx_volume ||
+           a->mus_volume != b->mus_volume || a->video_scale != b->video_scale ||
+           a->video_stretch != b->video_stretch || a->fullscreen != b->fullscreen ||
+           memcmp(a->keybinds, b->keybinds, sizeof(struct bindings));
+}
+
+// called with the lock held, which is let go for the write itself
+static void write_pending(struct cfg_writer *w)
+{
+    struct settings s;
+    struct bindings keybinds;
+
+    copy_settings(&s, &keybinds, &w->pending);
+    w->dirty = false;
+
+    SDL_UnlockMutex(w->lock);
+
+    if(write_cfg(w->filename, &s))
+    {
+        SDL_LockMutex(w->lock);
+        return;
+    }
+
+    log_debug("Saved settings to %s\n", w->filename);
+
+    SDL_LockMutex(w->lock);
+    copy_settings(&w->written, &w->written_keybinds, &s);
+    w->has_written = true;
+}
+
+static int writer_thread(void *data)
+{
+    struct cfg_writer *w = (struct cfg_writer *)data;
+    Sint32 wait = 0;
+
+    SDL_LockMutex(w->lock);
+
+    while(!w->quit)
+    {
+        if(!w->dirty)
+        {
+            SDL_CondWait(w->cond, w->lock);
+            continue;
+        }
+
+        // still changing: wait out the rest of the delay, which starts over if another change comes in
+        wait = (Sint32)(w->changed_at + CFG_WRITE_DELAY_MS - SDL_GetTicks());
+        if(wait > 0)
+        {
+            SDL_CondWaitTimeout(w->cond, w->lock, wait);
+            continue;
+        }
+
+        write_pending(w);
+    }
+
+    if(w->dirty)
+        write_pending(w);
+
+    SDL_UnlockMutex(w->lock);
+    return 0;
+}
+
+struct cfg_writer *cfg_writer_create(const char *filename, const struct settings *s)
+{
+    if(!filename || !s || !s->keybinds)
+        return NULL;
+
+    struct cfg_writer *w = (struct cfg_writer *)malloc(sizeof(struct cfg_writer));
+
+    w->filename = (char *)malloc(strlen(filename) + 1);
+    strcpy(w->filename, filename);
+
+    copy_settings(&w->seen, &w->seen_keybinds, s);
+    copy_settings(&w->pending, &w->pending_keybinds, s);
+    w->dirty = false;
+    w->changed_at = 0;
+    w->quit = false;
+    w->has_written = false;
+
+    w->lock = SDL_CreateMutex();
+    w->cond = SDL_CreateCond();
+    w->thread = SDL_CreateThread(writer_thread, "cfg_writer", w);
+
+    if(!w->thread)
+    {
+        log_err("SDL_CreateThread: %s\n", SDL_GetError());
+        cfg_writer_destroy(w);
+        return NULL;
+    }
+
+    return w;
+}
+
+void cfg_writer_destroy(struct cfg_writer *w)
+{
+    if(!w)
+        return;
+
+    if(w->thread)
+    {
+        SDL_LockMutex(w->lock);
+        w->quit = true;
+        SDL_CondSignal(w->cond);
+        SDL_UnlockMutex(w->lock);
+
+        SDL_WaitThread(w->thread, NULL);
+    }
+
+    SDL_DestroyCond(w->cond);
+    SDL_DestroyMutex(w->lock);
+    free(w->filename);
+    free(w);
+}
+
+void cfg_writer_update(struct cfg_writer *w, const struct settings *s)
+{
+    if(!w || !s || !s->keybinds)
+        return;
+
+    if(!settings_differ(&w->seen, s))
+        return;
+
+    copy_settings(&w->seen, &w->seen_keybinds, s);
+
+    SDL_LockMutex(w->lock);
+    copy_settings(&w->pending, &w->pending_keybinds, s);
+    w->dirty = true;
+    w->changed_at = SDL_GetTicks();
+    SDL_CondSignal(w->cond);
+    SDL_UnlockMutex(w->lock);
+}
+
+bool cfg_writer_wrote(struct cfg_writer *w, const struct settings *s)
+{
+    bool wrote = false;
+
+    if(!w || !s || !s->keybinds)
+        return false;
+
+    SDL_LockMutex(w->lock);
+    wrote = w->has_written && !settings_differ(&w->written, s);
+    SDL_UnlockMutex(w->lock);
+
+    return wrote;
+}
@@ -0,0 +1,47 @@
+#ifndef _cfg_writer_h
+#define _cfg_writer_h
+
+#include <SDL2/SDL.h>
+#include "core.h"
+
+#define CFG_WRITE_DELAY_MS 1000    // how long settings have to stay put before they're written
+
+/* saves settings changed while the game runs (options menu, video scale keys) back to the config
+   file with write_cfg() on a thread of its own. every change restarts the delay, so dragging a
+   volume slider across its range ends in one write rather than one per step */
+struct cfg_writer
+{
+    char *filename;
+
+    // the main thread's copy of what was last handed over, to spot changes without locking
+    struct settings seen;
+    struct bindings seen_keybinds;
+
+    SDL_Thread *thread;
+    SDL_mutex *lock;
+    SDL_cond *cond;
+
+    // under lock
+    struct settings pending;
+    struct bindings pending_keybinds;
+    bool dirty;
+    Uint32 changed_at;
+    bool quit;
+
+    // under lock: what the file was last made to say, so a reload can tell our own writes apart
+    struct settings written;
+    struct bindings written_keybinds;
+    bool has_written;
+};
+
+// s is what's in the file now; nothing is written until it changes
+struct cfg_writer *cfg_writer_create(const char *filename, const struct settings *s);
+void cfg_writer_destroy(struct cfg_writer *w);    // writes any change still waiting first
+
+// call once a frame with the live settings
+void cfg_writer_update(struct cfg_writer *w, const struct settings *s);
+
+// true if s, as read back from the file, is just what the writer last saved there
+bool cfg_writer_wrote(struct cfg_writer *w, const struct settings *s);
+
+#endif
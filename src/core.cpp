@@ -1,12 +1,21 @@
 #include "core.h"
 
+#include "anim_bg.h"
+#include "asset_cache.h"
+#include "asset_loader.h"
+#include "asset_pack.h"
+#include "bot.h"
+#include "cfg_writer.h"
 #include "debug.h"
 #include "file_io.h"
 #include "gfx.h"
 #include "gfx_structures.h"
 
 #include "game_menu.h"
+#include "random_stats.h"
 #include "replay.h"
+#include "seed_scan.h"
+#include "state_hash.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -131,57 +140,15 @@ static string make_path(const char *base, const char *subdir, const char *name,
     return path;
 }
 
-gfx_animation *load_anim_bg(coreState *cs, const char *directory, int frame_multiplier)
+struct anim_bg *load_anim_bg(coreState *cs, const char *directory, int frame_multiplier)
 {
-    if(!directory)
+    if(!cs || !directory)
         return NULL;
 
-    int i = 0;
-
-    gfx_animation *a = (gfx_animation *)malloc(sizeof(gfx_animation));
-    a->frame_multiplier = frame_multiplier;
-    a->x = 0;
-    a->y = 0;
-    a->flags = 0;
-    a->counter = 0;
-    a->rgba_mod = RGBA_DEFAULT;
-
-    struct stat s;
-    //chdir("gfx");
-    int err = stat(directory, &s);
-    //chdir("..");
+    string path = make_path(cs->settings->home_path, "gfx", directory, "");
+    string pack_name = string{"gfx/"} + directory;
 
-    if(-1 == err)
-    {
-        if(ENOENT == errno)
-        {
-            return NULL;
-        }
-    }
-    else
-    {
-        if(!S_ISDIR(s.st_mode))
-        {
-            return NULL;
-        }
-    }
-
-    // TODO: convert to new asset system - create an animation asset
-    /*
-    for(i = 0; i < 1000; i++) {
-       full_path = bformat("%s/%05d", directory, i);
-       if(load_asset(cs, ASSET_IMG, (char *)(full_path->data)) < 0) {
-          a->num_frames = i;
-          break;
-       } else {
-          //printf("Loaded frame #%d of animated bg: %s\n", i, full_path->data);
-       }
-
-        bdestroy(full_path);
-     }
-     */
-
-    return a;
+    return anim_bg_create(path.c_str(), pack_name.c_str(), cs->asset_pack, frame_multiplier);
 }
 
 void coreState_initialize(coreState *cs)
@@ -191,6 +158,9 @@ void coreState_initialize(coreState *cs)
     cs->fps = FPS;
     // cs->keyquit = SDLK_F11;
     cs->text_editing = 0;
+    cs->cfg_filename = NULL;
+    cs->cfg_mtime = 0;
+    cs->cfg_writer = NULL;
     cs->text_insert = NULL;
     cs->text_backspace = NULL;
     cs->text_delete = NULL;
@@ -219,7 +189,11 @@ void coreState_initialize(coreState *cs)
     cs->seven_pressed = 0;
     cs->nine_pressed = 0;
 
-    cs->assets = (assetdb *)malloc(sizeof(struct assetdb));
+    // mode assets stay NULL until their group is loaded
+    cs->assets = (assetdb *)calloc(1, sizeof(struct assetdb));
+    cs->asset_cache = asset_cache_create(ASSET_CACHE_BUDGET);
+    cs->asset_pack = NULL;
+    cs->asset_meta = NULL;
 
     cs->joystick = NULL;
     cs->prev_keys_raw = (struct keyflags){0};
@@ -244,8 +218,10 @@ void coreState_initialize(coreState *cs)
 
     cs->bg = NULL;
     cs->bg_old = NULL;
-    // cs->anim_bg = NULL;
-    // cs->anim_bg_old = NULL;
+    for(i = 0; i < 10; i++)
+        cs->g2_bgs[i] = NULL;
+    cs->anim_bg = NULL;
+    cs->anim_bg_next = NULL;
     cs->gfx_messages = NULL;
     cs->gfx_animations = NULL;
     cs->gfx_buttons = NULL;
@@ -260,6 +236,7 @@ void coreState_initialize(coreState *cs)
     cs->menu = NULL;
 
     cs->pracdata_mirror = NULL;
+    cs->bot = NULL;
 
     cs->sfx_volume = 32;
     cs->mus_volume = 32;
@@ -298,15 +275,6 @@ void coreState_destroy(coreState *cs)
         pracdata_destroy(cs->pracdata_mirror);
 }
 
-static void load_image(coreState *cs, gfx_image *img, const char *filename)
-{
-    string path = make_path(cs->settings->home_path, "gfx", filename, "");
-    if(!img_load(img, (const char *)path.c_str(), cs))
-    {
-        log_debug("Failed to load image '%s'\n", filename);
-    }
-}
-
 static void load_bitfont(BitFont *font, gfx_image *sheetImg, gfx_image *outlineSheetImg, unsigned int charW, unsigned int charH)
 {
     font->sheet = sheetImg->tex;
@@ -318,70 +286,180 @@ static void load_bitfont(BitFont *font, gfx_image *sheetImg, gfx_image *outlineS
 
 static int load_asset_volume(coreState *cs, const char *filename)
 {
-    string path = make_path(cs->settings->home_path, "audio", "volume", ".cfg");
-    vector<string> lines = split_file(path.c_str());
+    return get_asset_meta(cs->asset_meta, filename).volume;
+}
 
-    return get_asset_volume(lines, string{filename});
+static void load_asset(struct asset_loader *l, coreState *cs, int type, const char *subdir, const char *filename, void *dest)
+{
+    string path = make_path(cs->settings->home_path, subdir, filename, "");
+    string pack_name = string{subdir} + "/" + filename;
+    asset_loader_add(l, type, filename, path.c_str(), pack_name.c_str(), dest);
 }
 
-static void load_sfx(coreState *cs, struct sfx *s, const char *filename)
+// fonts aren't loaded yet, so a bare bar is all there is to show
+static void draw_load_progress(coreState *cs, int done, int total, void *data)
 {
-    string path = make_path(cs->settings->home_path, "audio", filename, "");
-    if(!sfx_load( s, (const char *)path.c_str() ))
+    SDL_Rect bar;
+    int w = 0;
+    int h = 0;
+
+    SDL_GetRendererOutputSize(cs->screen.renderer, &w, &h);
+
+    bar.x = w / 8;
+    bar.y = h / 2 - 4;
+    bar.w = (w * 3 / 4) * done / total;
+    bar.h = 8;
+
+    SDL_SetRenderDrawColor(cs->screen.renderer, 0, 0, 0, 255);
+    SDL_RenderClear(cs->screen.renderer);
+    SDL_SetRenderDrawColor(cs->screen.renderer, 255, 255, 255, 255);
+    SDL_RenderFillRect(cs->screen.renderer, &bar);
+    SDL_RenderPresent(cs->screen.renderer);
+}
+
+#define IMG(name, filename, group) +1
+#define MUS(name, filename, group) +1
+#define SFX(name) +1
+static const int ASSET_COUNT = 0
+#include "images.h"
+#include "music.h"
+#include "sfx.h"
+    ;
+#undef IMG
+#undef MUS
+#undef SFX
+
+// Mix_Music streams from disk, so this only stands for its decoder's buffers (prefetched tracks add their size)
+#define MUSIC_BYTES_ESTIMATE (256ul * 1024ul)
+
+int load_asset_group(coreState *cs, int group)
+{
+    if(!cs)
+        return -1;
+
+    struct asset_loader *l = asset_loader_create(ASSET_COUNT);
+    int rc = 0;
+
+    l->progress = draw_load_progress;
+    l->pack = cs->asset_pack;
+
+#define IMG(name, filename, g) \
+    if(g == group) load_asset(l, cs, ASSET_IMAGE, "gfx", filename, &cs->assets->name);
+#include "images.h"
+#undef IMG
+
+        // audio assets
+
+#define MUS(name, filename, g) \
+    if(g == group) load_asset(l, cs, ASSET_MUSIC, "audio", filename, &cs->assets->name);
+#include "music.h"
+#undef MUS
+
+    if(group == ASSET_GROUP_COMMON)
     {
-        log_debug("Failed to load sfx '%s'\n", filename);
+#define SFX(name) load_asset(l, cs, ASSET_SFX, "audio", #name, &cs->assets->name);
+#include "sfx.h"
+#undef SFX
     }
 
-    s->volume = load_asset_volume(cs, filename);
+    if(l->num_jobs)
+        rc = asset_loader_run(cs, l);
+    asset_loader_destroy(l);
+
+#define MUS(name, filename, g) \
+    if(g == group) cs->assets->name.volume = load_asset_volume(cs, filename);
+#include "music.h"
+#undef MUS
+
+    if(group == ASSET_GROUP_COMMON)
+    {
+#define SFX(name)                                                              \
+    cs->assets->name.volume = get_asset_meta(cs->asset_meta, #name).volume;    \
+    cs->assets->name.priority = get_asset_meta(cs->asset_meta, #name).priority;
+#include "sfx.h"
+#undef SFX
+    }
+
+    return rc;
 }
 
-static void load_music(coreState *cs, struct music *m, const char *filename)
+void unload_asset_group(coreState *cs, int group)
 {
-    string path = make_path(cs->settings->home_path, "audio", filename, "");
-    if(!music_load( m, (const char *)path.c_str() ))
-    {
-        log_debug("Failed to load music '%s'\n", filename);
+    if(!cs)
+        return;
+
+    // nothing may keep drawing a background that's gone
+#define IMG(name, filename, g)                       \
+    if(g == group)                                   \
+    {                                                \
+        if(cs->bg == cs->assets->name.tex)           \
+            cs->bg = NULL;                           \
+        if(cs->bg_old == cs->assets->name.tex)       \
+            cs->bg_old = NULL;                       \
+        img_destroy(&cs->assets->name);              \
     }
+#include "images.h"
+#undef IMG
 
-    m->volume = load_asset_volume(cs, filename);
+#define MUS(name, filename, g) \
+    if(g == group) music_destroy(&cs->assets->name);
+#include "music.h"
+#undef MUS
 }
 
-int load_files(coreState *cs)
+unsigned long asset_group_bytes(coreState *cs, int group)
 {
     if(!cs)
-        return -1;
+        return 0;
+
+    unsigned long bytes = 0;
+    int w = 0;
+    int h = 0;
 
-#define IMG(name, filename) load_image(cs, &cs->assets->name, filename);
+#define IMG(name, filename, g)                                                       \
+    if(g == group && cs->assets->name.tex &&                                         \
+       SDL_QueryTexture(cs->assets->name.tex, NULL, NULL, &w, &h) == 0)              \
+        bytes += (unsigned long)w * (unsigned long)h * 4;
 #include "images.h"
 #undef IMG
 
+#define MUS(name, filename, g) \
+    if(g == group && cs->assets->name.data) bytes += MUSIC_BYTES_ESTIMATE + cs->assets->name.mem_size;
+#include "music.h"
+#undef MUS
+
+    return bytes;
+}
+
+int load_files(coreState *cs)
+{
+    if(!cs)
+        return -1;
+
+    string pack_path = make_path(cs->settings->home_path, ".", "assets", ".pak");
+    string meta_path = make_path(cs->settings->home_path, "audio", "volume", ".cfg");
+
+    cs->asset_pack = asset_pack_open(pack_path.c_str());
+    cs->asset_meta = load_asset_meta(meta_path.c_str());
+
+    // everything else is loaded by asset_cache_acquire() once a mode asks for it
+    load_asset_group(cs, ASSET_GROUP_COMMON);
+
 #define FONT(name, sheetName, outlineSheetName, charW, charH) \
     load_bitfont(&cs->assets->name, &cs->assets->sheetName, &cs->assets->outlineSheetName, charW, charH);
 #include "fonts.h"
 #undef FONT
 
-        // audio assets
-
-#define MUS(name, filename) load_music(cs, &cs->assets->name, filename);
-#include "music.h"
-#undef MUS
-
-#define SFX(name) load_sfx(cs, &cs->assets->name, #name);
-#include "sfx.h"
-#undef SFX
+#ifdef ENABLE_ANIM_BG
+    // only finds the frames; each is streamed in while its section is being played
+    for(int i = 0; i < 10; i++)
+    {
+        bstring filename = bformat("g2_bg/bg%d", i);
+        cs->g2_bgs[i] = load_anim_bg(cs, (const char *)filename->data, 2);
+        bdestroy(filename);
+    }
+#endif
 
-    /*
-    #ifdef ENABLE_ANIM_BG
-       bstring filename;
-
-       for(i = 0; i < 10; i++) {
-          filename = bformat("g2_bg/bg%d", i);
-          cs->g2_bgs[i] = load_anim_bg(cs, filename->data, 2);
-          //if(cs->g2_bgs[i]) printf("Successfully loaded G2 bg #%d\n", i);
-          bdestroy(filename);
-       }
-    #endif
-    */
     return 0;
 }
 
@@ -393,6 +471,7 @@ int init(coreState *cs, struct settings *s)
 
         int n = 0;
         char *name = NULL;
+        struct stat st;
         // SDL_Texture *blank = NULL;
 
         // copy settings into main game structure
@@ -413,6 +492,11 @@ int init(coreState *cs, struct settings *s)
             cs->settings->mus_volume = s->mus_volume;
             cs->settings->master_volume = s->master_volume;
             cs->settings->player_name = s->player_name;
+            cs->settings->bot = s->bot;
+            cs->settings->cfg_reload = s->cfg_reload;
+            cs->settings->seed_scan = s->seed_scan;
+            cs->settings->rand_stats = s->rand_stats;
+            cs->settings->snapshot_bench = s->snapshot_bench;
 
             cs->sfx_volume = s->sfx_volume;
             cs->mus_volume = s->mus_volume;
@@ -442,6 +526,27 @@ int init(coreState *cs, struct settings *s)
         else
             cs->settings = &defaultsettings;
 
+        if(cs->settings->cfg_reload && cs->cfg_filename && stat(cs->cfg_filename, &st) == 0)
+        {
+            cs->cfg_mtime = st.st_mtime;
+            log_info("Watching %s for changes\n", cs->cfg_filename);
+        }
+
+        if(cs->settings != &defaultsettings && cs->cfg_filename)
+            cs->cfg_writer = cfg_writer_create(cs->cfg_filename, cs->settings);
+
+        if(cs->settings->seed_scan)
+            seed_scan_cfg(cs->settings->seed_scan);
+
+        if(cs->settings->rand_stats)
+            random_stats_cfg(cs->settings->rand_stats);
+
+        if(cs->settings->bot)
+        {
+            cs->bot = bot_create(bot_evaluate_default, NULL);
+            log_info("Bot player enabled\n");
+        }
+
         check(SDL_Init(SDL_INIT_EVENTS | SDL_INIT_TIMER | SDL_INIT_VIDEO | SDL_INIT_AUDIO) == 0,
               "SDL_Init: Error: %s\n",
               SDL_GetError());
@@ -453,8 +558,7 @@ int init(coreState *cs, struct settings *s)
                                 // support: %s\n", Mix_GetError());
         check(Mix_OpenAudio(22050, MIX_DEFAULT_FORMAT, 2, 1024) != -1, "Mix_OpenAudio: Error\n");
 
-        Mix_AllocateChannels(32);
-        Mix_Volume(-1, (cs->sfx_volume * cs->master_volume) / 100);
+        Mix_AllocateChannels(SFX_CHANNELS);
 
         if(SDL_NumJoysticks() > 0)
         {
@@ -541,14 +645,27 @@ void quit(coreState *cs)
 {
     scoredb_terminate(&cs->scores);
 
+    cfg_writer_destroy(cs->cfg_writer);
+    cs->cfg_writer = NULL;
+
+    // their textures have to go before the renderer does
+    cs->anim_bg = NULL;
+    cs->anim_bg_next = NULL;
+    for(int i = 0; i < 10; i++)
+    {
+        anim_bg_destroy(cs->g2_bgs[i]);
+        cs->g2_bgs[i] = NULL;
+    }
+    anim_bg_free_textures();
+
     if(cs->assets)
     {
 
-#define IMG(name, filename) img_destroy(&cs->assets->name);
+#define IMG(name, filename, group) img_destroy(&cs->assets->name);
 #include "images.h"
 #undef IMG
 
-#define MUS(name, filename) music_destroy(&cs->assets->name);
+#define MUS(name, filename, group) music_destroy(&cs->assets->name);
 #include "music.h"
 #undef MUS
 
@@ -559,6 +676,12 @@ void quit(coreState *cs)
         free(cs->assets);
     }
 
+    asset_cache_destroy(cs->asset_cache);
+
+    // after the assets, since loaded music still streams from it
+    asset_pack_close(cs->asset_pack);
+    asset_meta_destroy(cs->asset_meta);
+
     if(cs->screen.renderer)
         SDL_DestroyRenderer(cs->screen.renderer);
 
@@ -590,10 +713,8 @@ void quit(coreState *cs)
         cs->menu = NULL;
     }
 
-    /*for(int i = 0; i < 10; i++) {
-       if(cs->g2_bgs[i])
-          gfx_animation_destroy(cs->g2_bgs[i]);
-    }*/
+    bot_destroy(cs->bot);
+    cs->bot = NULL;
 
     gfx_quit(cs);
 
@@ -602,6 +723,51 @@ void quit(coreState *cs)
     SDL_Quit();
 }
 
+// picks up changes to volumes, video scale and bindings; everything else still needs a restart
+static void reload_cfg(coreState *cs)
+{
+    struct settings *s = NULL;
+    struct stat st;
+
+    if(!cs->settings->cfg_reload || !cs->cfg_filename || cs->frames % CFG_RELOAD_INTERVAL)
+        return;
+
+    if(stat(cs->cfg_filename, &st) || st.st_mtime == cs->cfg_mtime)
+        return;
+
+    cs->cfg_mtime = st.st_mtime;
+
+    s = parse_cfg(cs->cfg_filename);
+    if(!s)
+        return;
+
+    /* the writer's own saves change the mtime too; reading those back would undo anything changed
+       since the write was queued */
+    if(cfg_writer_wrote(cs->cfg_writer, s))
+    {
+        settings_destroy(s);
+        return;
+    }
+
+    cs->settings->master_volume = s->master_volume;
+    cs->settings->sfx_volume = s->sfx_volume;
+    cs->settings->mus_volume = s->mus_volume;
+
+    // copied in place, since the menus may hold on to the pointer
+    *cs->settings->keybinds = *s->keybinds;
+
+    if(cs->settings->video_scale != s->video_scale)
+    {
+        cs->settings->video_scale = s->video_scale;
+        cs->screen.w = cs->settings->video_scale * 960;
+        cs->screen.h = cs->settings->video_scale * 544;
+        SDL_SetWindowSize(cs->screen.window, cs->screen.w, cs->screen.h);
+    }
+
+    settings_destroy(s);
+    log_info("Reloaded %s\n", cs->cfg_filename);
+}
+
 int run(coreState *cs)
 {
     if(!cs)
@@ -621,6 +787,9 @@ int run(coreState *cs)
             return 1;
         }
 
+        if(cs->bot)
+            bot_update(cs, cs->bot);
+
         handle_replay_input(cs);
 
         update_input_repeat(cs);
@@ -682,21 +851,20 @@ int run(coreState *cs)
         gfx_drawanimations(cs, EMERGENCY_OVERRIDE);
 
         SDL_RenderPresent(cs->screen.renderer);
+        sfx_queue_flush(cs);
+
+        reload_cfg(cs);
+        cfg_writer_update(cs->cfg_writer, cs->settings);
 
+        // sound effect volumes are applied as each one starts
         if(cs->sfx_volume != cs->settings->sfx_volume)
-        {
             cs->sfx_volume = cs->settings->sfx_volume;
-            Mix_Volume(-1, (cs->sfx_volume * cs->master_volume) / 100);
-        }
 
         if(cs->mus_volume != cs->settings->mus_volume)
             cs->mus_volume = cs->settings->mus_volume;
 
         if(cs->master_volume != cs->settings->master_volume)
-        {
             cs->master_volume = cs->settings->master_volume;
-            Mix_Volume(-1, (cs->sfx_volume * cs->master_volume) / 100);
-        }
 
         timestamp = SDL_GetPerformanceCounter() - timestamp;
         long sleep_ns = framedelay(timestamp, cs->fps);
@@ -794,6 +962,10 @@ int procevents(coreState *cs)
             case SDL_QUIT:
                 return 1;
 
+            case SDL_APP_LOWMEMORY:
+                asset_cache_trim(cs, 0);
+                break;
+
             /*case SDL_JOYAXISMOTION:
                 k = &cs->keys_raw;
 
@@ -1510,6 +1682,8 @@ int procgame(game_t *g, int input_enabled)
 void handle_replay_input(coreState *cs)
 {
     game_t *g = cs->p1game;
+    struct replay_checkpoint *cp = NULL;
+
     if(g != NULL)
     {
         qrsdata *q = (qrsdata *)g->data;
@@ -1525,6 +1699,22 @@ void handle_replay_input(coreState *cs)
                 qrs_end_playback(g);
             else
             {
+                q->state_hash = qs_state_hash(g);
+
+                // only the first divergence matters, everything after it is expected to differ
+                cp = (unsigned int)q->playback_checkpoint < q->replay->num_checkpoints ? &q->replay->checkpoints[q->playback_checkpoint] : NULL;
+                if(cp && cp->frame == (unsigned int)q->playback_index)
+                {
+                    if(q->desync_frame < 0 && cp->hash != q->state_hash)
+                    {
+                        q->desync_frame = q->playback_index;
+                        log_err("Replay desync at frame %d (state hash %08x, recorded %08x)\n",
+                                q->playback_index, q->state_hash, cp->hash);
+                    }
+
+                    q->playback_checkpoint++;
+                }
+
                 unpack_input(q->replay->pinputs[q->playback_index], &cs->keys);
 
                 q->playback_index++;
@@ -1532,6 +1722,15 @@ void handle_replay_input(coreState *cs)
         }
         else if(q->recording)
         {
+            q->state_hash = qs_state_hash(g);
+
+            if(q->replay->len % REPLAY_CHECKPOINT_INTERVAL == 0 && q->replay->num_checkpoints < MAX_REPLAY_CHECKPOINTS)
+            {
+                cp = &q->replay->checkpoints[q->replay->num_checkpoints++];
+                cp->frame = q->replay->len;
+                cp->hash = q->state_hash;
+            }
+
             q->replay->pinputs[q->replay->len] = pack_input(&cs->keys_raw);
 
             q->replay->len++;
@@ -12,9 +12,12 @@
 #define RECENT_FRAMES 60
 #define FRAMEDELAY_ERR 0
 
+#define CFG_RELOAD_INTERVAL 60    // frames between looks at the config file when CFGRELOAD is on
+
 #define BUTTON_PRESSED_THIS_FRAME 2
 #define JOYSTICK_DEAD_ZONE 8000
 
+#include <time.h>
 #include <vector>
 #include <memory>
 
@@ -76,7 +79,7 @@ struct assetdb
 {
     gfx_image ASSET_IMG_NONE = {NULL};
 
-#define IMG(name, filename) gfx_image name;
+#define IMG(name, filename, group) gfx_image name;
 #include "images.h"
 #undef IMG
 
@@ -84,7 +87,7 @@ struct assetdb
 #include "fonts.h"
 #undef FONT
 
-#define MUS(name, filename) struct music name;
+#define MUS(name, filename, group) struct music name;
 #include "music.h"
 #undef MUS
 
@@ -108,6 +111,13 @@ struct settings
     char *home_path;
 
     const char *player_name;
+
+    bool bot;
+    bool cfg_reload;    // watch the config file and apply changes while running
+
+    char *seed_scan;    // SEEDSCAN, run once at startup; see seed_scan_cfg()
+    long rand_stats;    // RANDSTATS, likewise; see random_stats_cfg()
+    long snapshot_bench;    // SNAPBENCH, run once a game has been going for a while; see qs_snapshot_benchmark()
 };
 
 typedef struct game game_t;
@@ -160,15 +170,20 @@ struct coreState_
 
     char *cfg_filename;
     char *calling_path;
+    time_t cfg_mtime;
+    struct cfg_writer *cfg_writer;    // NULL when running on defaultsettings
 
     struct settings *settings;
     struct assetdb *assets;
+    struct asset_cache *asset_cache;
+    struct asset_pack *asset_pack;    // NULL to load loose files
+    struct asset_meta_table *asset_meta;
     SDL_Texture *bg;
     SDL_Texture *bg_old;
-    //gfx_animation *g2_bgs[10];
+    struct anim_bg *g2_bgs[10];
 
-    //gfx_animation *anim_bg;
-    //gfx_animation *anim_bg_old;
+    struct anim_bg *anim_bg;         // drawn in place of bg while set
+    struct anim_bg *anim_bg_next;    // started, takes over from anim_bg once its first frame is decoded
 
     gfx_message **gfx_messages;
     gfx_animation **gfx_animations;
@@ -201,6 +216,7 @@ struct coreState_
     game_t *p1game;
     game_t *menu;
     struct pracdata *pracdata_mirror;
+    struct bot *bot;    // when set, plays p1game in place of the controller
     std::vector<std::unique_ptr<GuiWindow>> guiWindowList;
 
     long double avg_sleep_ms;
@@ -245,8 +261,11 @@ struct bindings *bindings_copy(struct bindings *src);
 void coreState_initialize(coreState *cs);
 void coreState_destroy(coreState *cs);
 
-gfx_animation *load_anim_bg(coreState *cs, const char *directory, int frame_multiplier);
+struct anim_bg *load_anim_bg(coreState *cs, const char *directory, int frame_multiplier);
 int load_files(coreState *cs);
+int load_asset_group(coreState *cs, int group);
+void unload_asset_group(coreState *cs, int group);
+unsigned long asset_group_bytes(coreState *cs, int group);
 
 int init(coreState *cs, struct settings *s);
 void quit(coreState *cs);
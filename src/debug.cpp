@@ -2,50 +2,285 @@
 
 #include <stdarg.h>
 #include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <SDL2/SDL.h>
+#include <debugnet.h>
 #include <psp2/kernel/clib.h>
+#include <psp2/net/net.h>
+#include <psp2/sysmodule.h>
 
-static FILE *f;
+#define LOG_FILE "ux0:/data/shiro.log"
+#define LOG_IDLE_MS 20    // how long the writer sleeps when there's nothing to write
+#define LOG_NET_MEMORY 0x10000
 
-int debug_init() {
+// seq says whose turn the slot is: its index when free for a writer, index + 1 once the message is in
+struct log_slot
+{
+    SDL_atomic_t seq;
+    int level;
+    char msg[LOG_MSG_MAX];
+};
+
+static struct
+{
+    struct log_slot ring[LOG_RING_SIZE];
+    SDL_atomic_t tail;    // next slot to claim
+    int head;             // next slot to write out, only touched by the writer
+    SDL_atomic_t dropped;
+
+    SDL_Thread *thread;
+    SDL_sem *wake;
+    SDL_atomic_t quit;
+    SDL_mutex *flush_lock;    // without the thread, callers take turns writing out the ring
+
+    log_sink_fn sink;
+    void *sink_data;
+    FILE *f;
+    int sock;    // log_sink_socket()'s, -1 until it's first used, -2 if it couldn't be opened
+    struct sockaddr_in sock_addr;
+} logger;
+
+void log_sink_file(int level, const char *msg, void *data)
+{
+    if(logger.f)
+        fputs(msg, logger.f);
+}
+
+void log_sink_debugnet(int level, const char *msg, void *data)
+{
+    static const int levels[] = {ERROR, INFO, DEBUG};
+
+    log_sink_file(level, msg, data);
+    debugNetPrintf(levels[level], "%s", msg);
+}
+
+// only ever called from log_flush(), so from one thread at a time
+static int log_socket_open()
+{
+    static char net_memory[LOG_NET_MEMORY];
+    SceNetInitParam param;
+
+    sceSysmoduleLoadModule(SCE_SYSMODULE_NET);
+
+    // fails harmlessly if debugnet or anything else already set the network up
+    param.memory = net_memory;
+    param.size = sizeof(net_memory);
+    param.flags = 0;
+    sceNetInit(&param);
+
+    logger.sock = socket(AF_INET, SOCK_DGRAM, 0);
+    if(logger.sock < 0)
+    {
+        logger.sock = -2;
+        return 1;
+    }
+
+    memset(&logger.sock_addr, 0, sizeof(logger.sock_addr));
+    logger.sock_addr.sin_family = AF_INET;
+    logger.sock_addr.sin_port = htons(LOG_SOCKET_PORT);
+    logger.sock_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+
+    return 0;
+}
+
+void log_sink_socket(int level, const char *msg, void *data)
+{
+    log_sink_file(level, msg, data);
+
+    if(logger.sock == -1)
+        log_socket_open();
+
+    // nobody listening is fine, the datagram is just lost
+    if(logger.sock >= 0)
+        sendto(logger.sock, msg, strlen(msg), 0, (struct sockaddr *)&logger.sock_addr, sizeof(logger.sock_addr));
+}
+
+static void log_flush()
+{
+    struct log_slot *slot = NULL;
+    int dropped = SDL_AtomicSet(&logger.dropped, 0);
+    char msgbuf[64];
+
+    for(;;)
+    {
+        slot = &logger.ring[logger.head & (LOG_RING_SIZE - 1)];
+        if(SDL_AtomicGet(&slot->seq) != logger.head + 1)
+            break;
+
+        logger.sink(slot->level, slot->msg, logger.sink_data);
+
+        SDL_AtomicSet(&slot->seq, logger.head + LOG_RING_SIZE);
+        logger.head++;
+    }
+
+    if(dropped)
+    {
+        sceClibSnprintf(msgbuf, sizeof(msgbuf), "(%d log messages dropped)\n", dropped);
+        logger.sink(LOG_LEVEL_ERR, msgbuf, logger.sink_data);
+    }
+
+    if(logger.f)
+        fflush(logger.f);
+}
+
+static int log_thread(void *data)
+{
+    while(!SDL_AtomicGet(&logger.quit))
+    {
+        log_flush();
+        SDL_SemWaitTimeout(logger.wake, LOG_IDLE_MS);
+    }
+
+    log_flush();
+    return 0;
+}
+
+int debug_init()
+{
+    int i = 0;
+
+    for(i = 0; i < LOG_RING_SIZE; i++)
+        SDL_AtomicSet(&logger.ring[i].seq, i);
+
+    SDL_AtomicSet(&logger.tail, 0);
+    SDL_AtomicSet(&logger.dropped, 0);
+    SDL_AtomicSet(&logger.quit, 0);
+    logger.head = 0;
+
+    logger.f = fopen(LOG_FILE, "w");
+    logger.sock = -1;
+
+#if defined(LOG_DEBUGNET)
     debugNetInit(ip_server, port_server, DEBUG);
-    f = fopen("ux0:/data/shiro.log", "w");
+    logger.sink = log_sink_debugnet;
+#elif defined(LOG_SOCKET)
+    logger.sink = log_sink_socket;
+#else
+    logger.sink = log_sink_file;
+#endif
+    logger.sink_data = NULL;
+
+    logger.flush_lock = SDL_CreateMutex();
+    logger.wake = SDL_CreateSemaphore(0);
+    logger.thread = SDL_CreateThread(log_thread, "log", NULL);
+
+    // without the thread every message is written out as it's logged
+    if(!logger.thread)
+    {
+        log_err("SDL_CreateThread: %s\n", SDL_GetError());
+        return 1;
+    }
+
+    return 0;
 }
 
-void log_info(const char *format, ...) {
-    char msgbuf[0x800];
-    va_list args;
-    va_start(args, format);
-    sceClibVsnprintf(msgbuf, 0x800, format, args);
-    msgbuf[0x7FF] = 0;
-    va_end(args);
-    fprintf(f, msgbuf);
-    fclose(f);
-    f = fopen("ux0:/data/shiro.log", "a");
-    debugNetPrintf(INFO, msgbuf);
+void debug_quit()
+{
+    if(logger.thread)
+    {
+        SDL_AtomicSet(&logger.quit, 1);
+        SDL_SemPost(logger.wake);
+        SDL_WaitThread(logger.thread, NULL);
+        logger.thread = NULL;
+    }
+    else
+    {
+        SDL_LockMutex(logger.flush_lock);
+        log_flush();
+        SDL_UnlockMutex(logger.flush_lock);
+    }
+
+    // anything logged from here on is ignored
+    logger.sink = NULL;
+
+    if(logger.wake)
+        SDL_DestroySemaphore(logger.wake);
+    logger.wake = NULL;
+
+    if(logger.flush_lock)
+        SDL_DestroyMutex(logger.flush_lock);
+    logger.flush_lock = NULL;
+
+    if(logger.sock >= 0)
+        close(logger.sock);
+    logger.sock = -1;
+
+    if(logger.f)
+        fclose(logger.f);
+    logger.f = NULL;
 }
 
-void log_debug(const char *format, ...) {
-    char msgbuf[0x800];
-    va_list args;
-    va_start(args, format);
-    sceClibVsnprintf(msgbuf, 0x800, format, args);
-    msgbuf[0x7FF] = 0;
-    va_end(args);
-    fprintf(f, msgbuf);
-    fclose(f);
-    f = fopen("ux0:/data/shiro.log", "a");
-    debugNetPrintf(DEBUG, msgbuf);
+void log_set_sink(log_sink_fn sink, void *data)
+{
+    // swapped between writes, so a message never goes half to one sink and half to the other
+    if(logger.thread)
+    {
+        SDL_AtomicSet(&logger.quit, 1);
+        SDL_SemPost(logger.wake);
+        SDL_WaitThread(logger.thread, NULL);
+    }
+
+    logger.sink = sink ? sink : log_sink_file;
+    logger.sink_data = data;
+
+    if(logger.thread)
+    {
+        SDL_AtomicSet(&logger.quit, 0);
+        logger.thread = SDL_CreateThread(log_thread, "log", NULL);
+    }
 }
 
-void log_err(const char *format, ...) {
-    char msgbuf[0x800];
+void log_write(int level, const char *format, ...)
+{
+    struct log_slot *slot = NULL;
     va_list args;
+    int pos = 0;
+    int seq = 0;
+
+    if(!logger.sink)
+        return;
+
+    pos = SDL_AtomicGet(&logger.tail);
+
+    // bounded multi-producer queue: claim a slot by moving tail past it, fill it in, then publish it
+    for(;;)
+    {
+        slot = &logger.ring[pos & (LOG_RING_SIZE - 1)];
+        seq = SDL_AtomicGet(&slot->seq);
+
+        if(seq == pos)
+        {
+            if(SDL_AtomicCAS(&logger.tail, pos, pos + 1))
+                break;
+        }
+        else if(seq - pos < 0)
+        {
+            // the writer hasn't caught up yet
+            SDL_AtomicAdd(&logger.dropped, 1);
+            return;
+        }
+
+        pos = SDL_AtomicGet(&logger.tail);
+    }
+
     va_start(args, format);
-    sceClibVsnprintf(msgbuf, 0x800, format, args);
-    msgbuf[0x7FF] = 0;
+    sceClibVsnprintf(slot->msg, LOG_MSG_MAX, format, args);
+    slot->msg[LOG_MSG_MAX - 1] = 0;
     va_end(args);
-    fprintf(f, msgbuf);
-    fclose(f);
-    f = fopen("ux0:/data/shiro.log", "a");
-    debugNetPrintf(ERROR, msgbuf);
+
+    slot->level = level;
+    SDL_AtomicSet(&slot->seq, pos + 1);
+
+    if(!logger.thread)
+    {
+        SDL_LockMutex(logger.flush_lock);
+        log_flush();
+        SDL_UnlockMutex(logger.flush_lock);
+    }
+    else if(level == LOG_LEVEL_ERR)
+        SDL_SemPost(logger.wake);
 }
@@ -1,15 +1,55 @@
 #ifndef _DEBUG_H_
 #define _DEBUG_H_
 
-#include <debugnet.h>
-
 #define ip_server "192.168.43.66"
 #define port_server 18194
+#define LOG_SOCKET_PORT 18195    // where log_sink_socket() sends to on 127.0.0.1
+
+#define LOG_LEVEL_ERR   0
+#define LOG_LEVEL_INFO  1
+#define LOG_LEVEL_DEBUG 2
+
+// anything less important than this is compiled out
+#ifndef LOG_LEVEL
+#define LOG_LEVEL LOG_LEVEL_DEBUG
+#endif
+
+#define LOG_RING_SIZE 128    // messages, a power of two
+#define LOG_MSG_MAX 0x200    // longer messages are cut short
+
+/* messages are formatted on the calling thread into a lock-free ring and handed to the sink by a
+   writer thread, so logging never waits on the file system or the network. when the ring is full,
+   messages are dropped and counted rather than blocking the game */
+typedef void (*log_sink_fn)(int level, const char *msg, void *data);
+
+// writes to ux0:/data/shiro.log; the default
+void log_sink_file(int level, const char *msg, void *data);
+// the file, and debugNetPrintf() to ip_server:port_server; the default when built with LOG_DEBUGNET
+void log_sink_debugnet(int level, const char *msg, void *data);
+/* the file, and each message as a UDP datagram to 127.0.0.1:LOG_SOCKET_PORT; stands in for debugnet
+   when testing, without a PC on the network. the default when built with LOG_SOCKET */
+void log_sink_socket(int level, const char *msg, void *data);
 
 int debug_init();
-void log_info(const char *format, ...);
-void log_debug(const char *format, ...);
-void log_err(const char *format, ...);
+void debug_quit();    // writes out whatever is still queued, then stops the writer thread
+void log_set_sink(log_sink_fn sink, void *data);
+
+void log_write(int level, const char *format, ...);
+
+#define log_err(...) log_write(LOG_LEVEL_ERR, __VA_ARGS__)
+
+#if LOG_LEVEL >= LOG_LEVEL_INFO
+#define log_info(...) log_write(LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define log_info(...) ((void)0)
+#endif
+
+#if LOG_LEVEL >= LOG_LEVEL_DEBUG
+#define log_debug(...) log_write(LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define log_debug(...) ((void)0)
+#endif
+
 #define check(A, M, ...) if(!(A)) { log_err(M, ##__VA_ARGS__); errno=0; goto error; }
 
-#endif // _DEBUG_H_
\ No newline at end of file
+#endif // _DEBUG_H_
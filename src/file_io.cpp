@@ -3,6 +3,7 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <errno.h>
+#include <limits.h>
 #include <time.h>
 #include "debug.h"
 #include <SDL2/SDL.h>
@@ -10,6 +11,7 @@
 #include <sys/types.h>
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 #include "stringtools.hpp"
 
@@ -17,137 +19,383 @@
 
 using namespace std;
 
-struct settings *parse_cfg(const char *filename)
+struct cfg_option
 {
-    if(!filename)
+    const char *key;
+    int type;
+    long min;    // CFG_INT only
+    long max;
+};
+
+static const struct cfg_option cfg_schema[] = {
+    {"HOME_PATH", CFG_STRING, 0, 0},
+    {"PLAYERNAME", CFG_STRING, 0, 0},
+    {"MASTERVOLUME", CFG_INT, 0, 100},
+    {"SFXVOLUME", CFG_INT, 0, 100},
+    {"MUSICVOLUME", CFG_INT, 0, 100},
+    {"VIDEOSCALE", CFG_INT, 1, 5},
+    {"VIDEOSTRETCH", CFG_BOOL, 0, 0},
+    {"FULLSCREEN", CFG_BOOL, 0, 0},
+    {"BOT", CFG_BOOL, 0, 0},
+    {"CFGRELOAD", CFG_BOOL, 0, 0},
+    {"SEEDSCAN", CFG_STRING, 0, 0},
+    {"RANDSTATS", CFG_INT, 0, LONG_MAX},
+    {"SNAPBENCH", CFG_INT, 0, LONG_MAX},
+    {"P1CONTROLS", CFG_SECTION, 0, 0},
+    {"P1LEFT", CFG_KEY, 0, 0},
+    {"P1RIGHT", CFG_KEY, 0, 0},
+    {"P1UP", CFG_KEY, 0, 0},
+    {"P1DOWN", CFG_KEY, 0, 0},
+    {"P1A", CFG_KEY, 0, 0},
+    {"P1B", CFG_KEY, 0, 0},
+    {"P1C", CFG_KEY, 0, 0},
+    {"P1D", CFG_KEY, 0, 0},
+    {"P1ESCAPE", CFG_KEY, 0, 0}};
+
+static const struct cfg_option *find_cfg_option(const string& key)
+{
+    static unordered_map<string, const struct cfg_option *> index;
+    unsigned int i = 0;
+
+    if(index.empty())
     {
-        return NULL;
+        for(i = 0; i < sizeof(cfg_schema) / sizeof(cfg_schema[0]); i++)
+            index.emplace(cfg_schema[i].key, &cfg_schema[i]);
     }
 
-    struct settings *s = (struct settings *)malloc(sizeof(struct settings));
-    vector<string> cfg_file_lines = split_file(filename);
+    auto it = index.find(key);
+    return it != index.end() ? it->second : NULL;
+}
 
-    if(cfg_file_lines.empty())
-    {
-        log_err("Error splitting config file\n");
-    }
+// false if value doesn't fit the option's type
+static bool parse_cfg_value(const struct cfg_option *opt, const string& value, struct cfg_value *v)
+{
+    v->type = opt->type;
+    v->num = 0;
 
-    string sfxvolume = "SFXVOLUME";
-    string musicvolume = "MUSICVOLUME";
-    string mastervolume = "MASTERVOLUME";
-    string home_path = "HOME_PATH";
-    string videoscale = "VIDEOSCALE";
-    string player_name = "PLAYERNAME";
-    string fscreen = "FULLSCREEN";
-    string videostretch = "VIDEOSTRETCH";
-
-    s->keybinds = get_cfg_bindings(cfg_file_lines);
-
-    s->sfx_volume = get_cfg_option(cfg_file_lines, sfxvolume);
-    s->mus_volume = get_cfg_option(cfg_file_lines, musicvolume);
-    s->master_volume = get_cfg_option(cfg_file_lines, mastervolume);
-    s->video_scale = get_cfg_option(cfg_file_lines, videoscale);
-    s->home_path = get_cfg_string(cfg_file_lines, home_path);
-
-    int fscreenInt = get_cfg_option(cfg_file_lines, fscreen);
-    if(fscreenInt != OPTION_INVALID)
+    switch(opt->type)
     {
-        s->fullscreen = fscreenInt >= 1 ? true : false;
-    }
-    else
-    {
-        s->fullscreen = defaultsettings.fullscreen;
+        case CFG_INT:
+            v->num = parse_long(value.c_str());
+            return v->num != OPTION_INVALID && v->num >= opt->min && v->num <= opt->max;
+
+        case CFG_BOOL:
+            v->num = parse_long(value.c_str());
+            if(v->num == OPTION_INVALID)
+                return false;
+
+            v->num = v->num >= 1;
+            return true;
+
+        case CFG_STRING:
+            v->str = value;
+            return true;
+
+        case CFG_KEY:
+            v->num = str_sdlk(value);
+            return v->num > 0;
+
+        default:
+            return true;
     }
+}
+
+struct cfg_table *read_cfg(const char *filename)
+{
+    if(!filename)
+        return NULL;
+
+    vector<string> lines = split_file(filename);
+    struct cfg_table *t = NULL;
+    const struct cfg_option *opt = NULL;
+    bool in_controls = false;
 
-    int vstretchInt = get_cfg_option(cfg_file_lines, videostretch);
-    if(vstretchInt != OPTION_INVALID)
+    if(lines.empty())
     {
-        s->video_stretch = vstretchInt >= 1 ? true : false;
+        log_err("Error splitting config file\n");
+        return NULL;
     }
-    else
+
+    t = new cfg_table;
+
+    for(auto& str : lines)
     {
-        s->video_stretch = defaultsettings.video_stretch;
+        if(str.empty() || str[0] == '#')
+            continue;
+
+        // <label> [value]
+        vector<string> tokens = strtools::words(str);
+        struct cfg_value v;
+
+        if(tokens.empty())
+            continue;
+
+        opt = find_cfg_option(tokens[0]);
+        if(!opt)
+        {
+            log_debug("Unknown setting %s in config file\n", tokens[0].c_str());
+            continue;
+        }
+
+        if(opt->type == CFG_SECTION)
+        {
+            in_controls = true;
+            continue;
+        }
+
+        // bindings only count once their section has started
+        if(opt->type == CFG_KEY && !in_controls)
+            continue;
+
+        if(tokens.size() < 2 || !parse_cfg_value(opt, tokens.back(), &v))
+        {
+            log_info("Setting %s is invalid, using default\n", tokens[0].c_str());
+            continue;
+        }
+
+        // like before, the first line for a setting is the one that counts
+        t->values.emplace(tokens[0], v);
     }
 
-    s->player_name = get_cfg_string(cfg_file_lines, player_name);
+    return t;
+}
+
+void cfg_table_destroy(struct cfg_table *t)
+{
+    delete t;
+}
+
+static const struct cfg_value *get_cfg_value(const struct cfg_table *t, const char *key)
+{
+    if(!t)
+        return NULL;
+
+    auto it = t->values.find(key);
+    return it != t->values.end() ? &it->second : NULL;
+}
+
+static long cfg_num(const struct cfg_table *t, const char *key, long def)
+{
+    const struct cfg_value *v = get_cfg_value(t, key);
+    return v ? v->num : def;
+}
+
+// NULL if not set; otherwise malloc()ed
+static char *cfg_str(const struct cfg_table *t, const char *key)
+{
+    const struct cfg_value *v = get_cfg_value(t, key);
+    char *str = NULL;
+
+    if(!v)
+        return NULL;
+
+    str = (char *)malloc(v->str.length() + 1);
+    strcpy(str, v->str.c_str());
+    return str;
+}
+
+struct settings *settings_from_cfg(const struct cfg_table *t)
+{
+    struct settings *s = (struct settings *)malloc(sizeof(struct settings));
+    struct bindings *b = NULL;
+
+    s->keybinds = bindings_copy(defaultsettings.keybinds);
+    b = s->keybinds;
+
+    b->left = cfg_num(t, "P1LEFT", b->left);
+    b->right = cfg_num(t, "P1RIGHT", b->right);
+    b->up = cfg_num(t, "P1UP", b->up);
+    b->down = cfg_num(t, "P1DOWN", b->down);
+    b->a = cfg_num(t, "P1A", b->a);
+    b->b = cfg_num(t, "P1B", b->b);
+    b->c = cfg_num(t, "P1C", b->c);
+    b->d = cfg_num(t, "P1D", b->d);
+    b->escape = cfg_num(t, "P1ESCAPE", b->escape);
+
+    s->video_scale = cfg_num(t, "VIDEOSCALE", defaultsettings.video_scale);
+    s->video_stretch = cfg_num(t, "VIDEOSTRETCH", defaultsettings.video_stretch);
+    s->fullscreen = cfg_num(t, "FULLSCREEN", defaultsettings.fullscreen);
+
+    s->master_volume = cfg_num(t, "MASTERVOLUME", defaultsettings.master_volume);
+    s->sfx_volume = cfg_num(t, "SFXVOLUME", defaultsettings.sfx_volume);
+    s->mus_volume = cfg_num(t, "MUSICVOLUME", defaultsettings.mus_volume);
+
+    s->home_path = cfg_str(t, "HOME_PATH");
+
+    s->player_name = cfg_str(t, "PLAYERNAME");
     if(s->player_name == NULL)
     {
-        log_info("Could not find %s setting in config file. Using default player name \"%s\"\n", player_name.c_str(), defaultsettings.player_name);
+        log_info("Could not find PLAYERNAME setting in config file. Using default player name \"%s\"\n", defaultsettings.player_name);
         s->player_name = defaultsettings.player_name;
     }
 
-    if(s->sfx_volume == OPTION_INVALID || s->sfx_volume < 0 || s->sfx_volume > 100)
-    {
-        s->sfx_volume = 100;
-    }
-    if(s->mus_volume == OPTION_INVALID || s->mus_volume < 0 || s->mus_volume > 100)
-    {
-        s->mus_volume = 100;
-    }
-    if(s->master_volume == OPTION_INVALID || s->master_volume < 0 || s->master_volume > 100)
-    {
-        s->master_volume = 100;
-    }
-    if(s->video_scale == OPTION_INVALID || s->video_scale < 1 || s->video_scale > 5)
+    s->bot = cfg_num(t, "BOT", defaultsettings.bot);
+    s->cfg_reload = cfg_num(t, "CFGRELOAD", defaultsettings.cfg_reload);
+    s->seed_scan = cfg_str(t, "SEEDSCAN");
+    s->rand_stats = cfg_num(t, "RANDSTATS", defaultsettings.rand_stats);
+    s->snapshot_bench = cfg_num(t, "SNAPBENCH", defaultsettings.snapshot_bench);
+
+    return s;
+}
+
+struct settings *parse_cfg(const char *filename)
+{
+    if(!filename)
     {
-        s->video_scale = 1;
+        return NULL;
     }
 
+    struct cfg_table *t = read_cfg(filename);
+    struct settings *s = settings_from_cfg(t);
+
+    cfg_table_destroy(t);
     return s;
 }
 
-long get_cfg_option(vector<string>& lines, string label)
+void settings_destroy(struct settings *s)
 {
-    for(auto str : lines)
+    if(!s || s == &defaultsettings)
+        return;
+
+    free(s->keybinds);
+    free(s->home_path);
+    free(s->seed_scan);
+    if(s->player_name != defaultsettings.player_name)
+        free((char *)s->player_name);
+
+    free(s);
+}
+
+// the inverse of str_sdlk()
+static string sdlk_str(SDL_Keycode k)
+{
+    if(k > ' ' && k < 0x7f && k != 'K')
+        return string(1, (char)k);
+
+    return strtools::format("K%ld", (long)k);
+}
+
+int write_cfg(const char *filename, const struct settings *s)
+{
+    if(!filename || !s)
+        return -1;
+
+    vector<string> lines = split_file(filename);
+    vector<pair<string, string>> values;
+    vector<bool> written;
+    string tmp_filename = string{filename} + ".tmp";
+    FILE *f = NULL;
+    bool in_controls = false;
+    bool has_controls = false;
+    bool failed = false;
+    size_t first_binding = 0;
+    size_t i = 0;
+
+    values.emplace_back("MASTERVOLUME", to_string(s->master_volume));
+    values.emplace_back("SFXVOLUME", to_string(s->sfx_volume));
+    values.emplace_back("MUSICVOLUME", to_string(s->mus_volume));
+    values.emplace_back("VIDEOSCALE", to_string((int)s->video_scale));
+    values.emplace_back("VIDEOSTRETCH", s->video_stretch ? "1" : "0");
+    values.emplace_back("FULLSCREEN", s->fullscreen ? "1" : "0");
+
+    // from here on, only under P1CONTROLS
+    first_binding = values.size();
+
+    values.emplace_back("P1LEFT", sdlk_str(s->keybinds->left));
+    values.emplace_back("P1RIGHT", sdlk_str(s->keybinds->right));
+    values.emplace_back("P1UP", sdlk_str(s->keybinds->up));
+    values.emplace_back("P1DOWN", sdlk_str(s->keybinds->down));
+    values.emplace_back("P1A", sdlk_str(s->keybinds->a));
+    values.emplace_back("P1B", sdlk_str(s->keybinds->b));
+    values.emplace_back("P1C", sdlk_str(s->keybinds->c));
+    values.emplace_back("P1D", sdlk_str(s->keybinds->d));
+    values.emplace_back("P1ESCAPE", sdlk_str(s->keybinds->escape));
+
+    written.assign(values.size(), false);
+
+    // only the value of the line read_cfg() would use is replaced, so its spacing survives
+    for(auto& str : lines)
     {
-        if(str[0] == '#')
+        if(str.empty() || str[0] == '#')
+            continue;
+
+        vector<string> tokens = strtools::words(str);
+
+        if(tokens.empty())
+            continue;
+
+        if(tokens[0] == "P1CONTROLS")
         {
+            in_controls = true;
+            has_controls = true;
             continue;
         }
 
-        if(str.find(label) == 0)
+        for(i = 0; i < values.size(); i++)
         {
-            vector<string> tokens = strtools::words(str);
-            if(!tokens.empty())
-            {
-                return parse_long(tokens.back().c_str());
-            }
+            if(tokens[0] != values[i].first || written[i] || (i >= first_binding && !in_controls))
+                continue;
+
+            if(tokens.size() < 2)
+                str = values[i].first + " " + values[i].second;
             else
-            {
-                return OPTION_INVALID;
-            }
+                str.replace(str.rfind(tokens.back()), tokens.back().length(), values[i].second);
+
+            written[i] = true;
+            break;
         }
     }
 
-    return OPTION_INVALID;
-}
+    for(i = 0; i < values.size(); i++)
+    {
+        if(written[i])
+            continue;
 
-char *get_cfg_string(vector<string>& lines, string label)
-{
-    for(auto str : lines)
+        if(i >= first_binding && !has_controls)
+        {
+            lines.push_back("P1CONTROLS");
+            has_controls = true;
+        }
+
+        lines.push_back(values[i].first + " " + values[i].second);
+    }
+
+    f = fopen(tmp_filename.c_str(), "wb");
+    if(!f)
     {
-        if(str[0] == '#')
+        log_err("Can't write %s\n", tmp_filename.c_str());
+        return 1;
+    }
+
+    for(auto& str : lines)
+    {
+        if(fputs(str.c_str(), f) < 0 || fputc('\n', f) == EOF)
         {
-            continue;
+            failed = true;
+            break;
         }
+    }
 
-        if(str.find(label) == 0)
+    if(fclose(f) || failed)
+    {
+        log_err("Can't write %s\n", tmp_filename.c_str());
+        remove(tmp_filename.c_str());
+        return 1;
+    }
+
+    // sceIoRename() won't replace an existing file; if that's what stopped it, the complete copy
+    // is still there under the temporary name should the second attempt not happen
+    if(rename(tmp_filename.c_str(), filename))
+    {
+        remove(filename);
+        if(rename(tmp_filename.c_str(), filename))
         {
-            vector<string> tokens = strtools::words(str);
-            if(!tokens.empty())
-            {
-                char *str = (char *)malloc(tokens.back().length() + 1);
-                strcpy(str, tokens.back().c_str());
-                return str;
-            }
-            else
-            {
-                return NULL;
-            }
+            log_err("Can't replace %s\n", filename);
+            return 1;
         }
     }
 
-    return NULL;
+    return 0;
 }
 
 vector<string> split_file(const char *filename)
@@ -171,102 +419,76 @@ vector<string> split_file(const char *filename)
     return strtools::split(buf, '\n');
 }
 
-struct bindings *get_cfg_bindings(vector<string>& lines)
+static struct asset_meta default_asset_meta()
 {
-    struct bindings *bindings = bindings_copy(&defaultkeybinds[0]);
-    string label = strtools::format("P%dCONTROLS", 1);
-
-    string keystrings[9] = {strtools::format("P%dLEFT", 1),
-                            strtools::format("P%dRIGHT", 1),
-                            strtools::format("P%dUP", 1),
-                            strtools::format("P%dDOWN", 1),
-                            strtools::format("P%dA", 1),
-                            strtools::format("P%dB", 1),
-                            strtools::format("P%dC", 1),
-                            strtools::format("P%dD", 1),
-                            strtools::format("P%dESCAPE", 1)};
-
-    SDL_Keycode *keyptrs[9] = {
-        &bindings->left, &bindings->right, &bindings->up, &bindings->down, &bindings->a, &bindings->b, &bindings->c, &bindings->d, &bindings->escape};
-
-    unsigned int lineIndex = 0;
-    for(auto str : lines)
-    {
-        if(str[0] == '#')
-        {
-            continue;
-        }
-
-        if(str.find(label) == 0)
-        {
-            break;
-        }
+    struct asset_meta m;
+    m.volume = 128;
+    m.priority = 0;
 
-        lineIndex++;
-    }
+    return m;
+}
 
-    lineIndex++;
+struct asset_meta_table *load_asset_meta(const char *filename)
+{
+    struct asset_meta_table *t = new asset_meta_table;
+    vector<string> lines = split_file(filename);
 
-    for(; lineIndex < lines.size(); lineIndex++)
+    for(auto& str : lines)
     {
-        string& str = lines[lineIndex];
-        if(str[0] == '#')
+        if(str.empty() || str[0] == '#')
         {
             continue;
         }
 
+        // <asset name> <volume 0-100> [priority]
         vector<string> tokens = strtools::words(str);
 
-        if(tokens.empty())
+        if(tokens.size() < 2)
         {
             continue;
         }
 
-        for(int j = 0; j < 9; j++)
+        struct asset_meta m = default_asset_meta();
+        long volume = parse_long(tokens[1].c_str());
+
+        if(volume != OPTION_INVALID && volume >= 0 && volume <= 100)
+        {
+            m.volume = (128 * volume) / 100;
+        }
+
+        if(tokens.size() > 2)
         {
-            if(tokens[0] == keystrings[j])
+            long priority = parse_long(tokens[2].c_str());
+            if(priority != OPTION_INVALID)
             {
-                SDL_Keycode val = str_sdlk(tokens.back());
-                if(val > 0)
-                {
-                    (*keyptrs[j]) = val;
-                    break;
-                }
-                else
-                {
-                    log_debug("Binding for %s is invalid, using default\n", keystrings[j].c_str());
-                }
+                m.priority = priority;
             }
         }
+
+        // like before, the first line for an asset is the one that counts
+        t->entries.emplace(tokens[0], m);
     }
 
-    return bindings;
+    return t;
 }
 
-int get_asset_volume(vector<string>& lines, string asset_name)
+void asset_meta_destroy(struct asset_meta_table *t)
 {
-    for(auto str : lines)
-    {
-        if(str[0] == '#')
-        {
-            continue;
-        }
+    delete t;
+}
 
-        if(str.find(asset_name) == 0)
+struct asset_meta get_asset_meta(const struct asset_meta_table *t, const char *asset_name)
+{
+    if(t && asset_name)
+    {
+        auto it = t->entries.find(asset_name);
+        if(it != t->entries.end())
         {
-            vector<string> tokens = strtools::words(str);
-            int volume = parse_long(tokens.back().c_str());
-
-            if(volume == OPTION_INVALID || volume < 0 || volume > 100)
-            {
-                volume = 100;
-            }
-
-            return (128 * volume) / 100;
+            return it->second;
         }
     }
 
-    return 128;
+    return default_asset_meta();
 }
 
 long parse_long(const char *str)
@@ -5,6 +5,7 @@
 #include "core.h"
 
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #define OPTION_INVALID -255
@@ -12,13 +13,61 @@
 #define MINIMUM_REPLAY_SIZE (long)(REPLAY_HEADER_SIZE + sizeof(struct keyflags))
 #define REPLAY_HEADER_SIZE (6*sizeof(int) + 3*sizeof(long))
 
+enum cfg_type
+{
+    CFG_SECTION,    // a label on its own, like P1CONTROLS
+    CFG_INT,
+    CFG_BOOL,
+    CFG_STRING,
+    CFG_KEY         // a character, or K followed by an SDL keycode
+};
+
+struct cfg_value
+{
+    int type;
+    long num;           // CFG_INT, CFG_BOOL (0 or 1) and CFG_KEY
+    std::string str;    // CFG_STRING
+};
+
+// every known setting in a config file, already checked against the schema in file_io.cpp
+struct cfg_table
+{
+    std::unordered_map<std::string, struct cfg_value> values;
+};
+
+// one pass over the file; NULL if it can't be read
+struct cfg_table *read_cfg(const char *filename);
+void cfg_table_destroy(struct cfg_table *t);
+
+// anything missing or invalid in the file is taken from defaultsettings
 struct settings *parse_cfg(const char *filename);
-long get_cfg_option(std::vector<std::string>& lines, std::string label);
-char *get_cfg_string(std::vector<std::string>& lines, std::string label);
+struct settings *settings_from_cfg(const struct cfg_table *t);
+void settings_destroy(struct settings *s);
+
+/* writes the volumes, video options and bindings from s into the config file, keeping everything
+   else in it (comments, layout, other settings) as it was. the new file is written next to the old
+   one and renamed over it, so a crash part way through never leaves a half-written config */
+int write_cfg(const char *filename, const struct settings *s);
+
 std::vector<std::string> split_file(const char *filename);
 
-struct bindings *get_cfg_bindings(std::vector<std::string>& lines);
-int get_asset_volume(std::vector<std::string>& lines, std::string asset_name);
+// per-asset settings from audio/volume.cfg; new per-asset properties go here and in load_asset_meta()
+struct asset_meta
+{
+    int volume;      // 0 to MIX_MAX_VOLUME
+    int priority;    // sound effects only: who wins when too many want to play at once
+};
+
+struct asset_meta_table
+{
+    std::unordered_map<std::string, struct asset_meta> entries;
+};
+
+// reads the file once; a missing file gives an empty table, so every asset gets the defaults
+struct asset_meta_table *load_asset_meta(const char *filename);
+void asset_meta_destroy(struct asset_meta_table *t);
+struct asset_meta get_asset_meta(const struct asset_meta_table *t, const char *asset_name);
+
 long parse_long(const char *str);
 SDL_Keycode str_sdlk(std::string str);
 
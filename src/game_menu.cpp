@@ -1303,6 +1303,7 @@ int mload_practice(game_t *g, int val)
 
     int game_type_ = 0;
     int lock_protect_ = 0;
+    int garbage_delay_ = 0;
 
     // TODO: piece sequence restore from pracdata struct (need to save char* that the user enters)
 
@@ -1803,12 +1804,50 @@ int mload_practice(game_t *g, int val)
     /* */
     //
 
+    d->menu[14] = menu_opt_create(MENU_MULTIOPT, NULL, bfromcstr("RISING GARBAGE"));
+    m = d->menu[14];
+    d2 = (struct multi_opt_data *)m->data;
+    d2->num = 6;
+    d2->param = &q->pracdata->garbage_delay;
+    d2->vals = (int *)malloc(6 * sizeof(int));
+    d2->labels = (bstring *)malloc(6 * sizeof(bstring));
+    d2->labels[0] = bfromcstr("OFF");
+    d2->vals[0] = 0;
+    for(i = 1; i < 6; i++)
+    {
+        d2->labels[i] = bformat("EVERY %d", 4 * i);
+        d2->vals[i] = 4 * i;
+    }
+
+    if(pracdata_mirror_existed)
+    {
+        garbage_delay_ = q->pracdata->garbage_delay;
+        d2->selection = garbage_delay_ / 4;
+    }
+    else
+    {
+        d2->selection = 0;
+        (*d2->param) = d2->vals[d2->selection];
+    }
+
+    m->x = 16 * 16;
+    m->y = 8 * 16 + 15 * 16;
+    m->value_x = m->x + 15 * 8;
+    m->value_y = m->y + 16;
+    m->label_text_flags = DRAWTEXT_FIXEDSYS_FONT;
+    m->label_text_rgba = 0xC0C020FF;
+    m->value_text_flags = DRAWTEXT_FIXEDSYS_FONT | DRAWTEXT_ALIGN_RIGHT;
+
+    //
+    /* */
+    //
+
     d->menu[MENU_PRACTICE_NUMOPTS - 1] = menu_opt_create(MENU_TEXTINPUT, qs_update_pracdata, bfromcstr("PIECE SEQUENCE"));
     m = d->menu[MENU_PRACTICE_NUMOPTS - 1];
     d7 = (struct text_opt_data *)m->data;
     d7->visible_chars = 16;
     m->x = 16 * 16;
-    m->y = 8 * 16 + 15 * 16;
+    m->y = 8 * 16 + 17 * 16;
     m->value_x = m->x + 16;
     m->value_y = m->y + 16;
     m->label_text_flags = DRAWTEXT_FIXEDSYS_FONT;
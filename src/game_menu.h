@@ -5,7 +5,7 @@
 #include "core.h"
 #include <stdbool.h>
 
-#define MENU_PRACTICE_NUMOPTS 15
+#define MENU_PRACTICE_NUMOPTS 16
 
 #define MENU_ID_MAIN 0
 #define MENU_ID_PRACTICE 1
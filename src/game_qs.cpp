@@ -6,6 +6,7 @@
 #include <stdlib.h>
 #include <time.h>
 #include <string>
+#include "asset_cache.h"
 #include "bstr_to_std.hpp"
 
 #include "core.h"
@@ -18,6 +19,7 @@
 #include "timer.h"
 
 #include "replay.h"
+#include "snapshot.h"
 
 using namespace std;
 
@@ -442,15 +444,42 @@ static int find_music(int level, const struct levelmusic *table)
     return music;
 }
 
-static void play_or_halt_music(qrsdata *q, coreState *cs, struct music *first_music, int desired_music)
+// the track that comes after the one for level, -1 if there's none
+static int find_next_music(int level, const struct levelmusic *table)
 {
+    int i = 0;
+
+    for(i = 0; table[i].fromlevel <= level; ++i)
+        ;
+
+    for(; table[i].musicindex == -1; ++i)
+    {
+        if(table[i].fromlevel >= 9999)
+            return -1;
+    }
+
+    return table[i].musicindex;
+}
+
+static void play_or_halt_music(qrsdata *q, coreState *cs, struct music *first_music, const struct levelmusic *table)
+{
+    int desired_music = find_music(q->level, table);
+    int next_music = -1;
+
     if(q->music == desired_music)
         return;
 
     q->music = desired_music;
     log_debug("music: %d\n", q->music);
     if(desired_music == -1)
+    {
         Mix_HaltMusic();
+
+        // the quiet stretch before a section boundary is when to get the next track off storage
+        next_music = find_next_music(q->level, table);
+        if(next_music != -1)
+            music_prefetch(first_music + next_music);
+    }
     else
         music_play(first_music + desired_music, cs);
 }
@@ -460,24 +489,24 @@ static void update_music(qrsdata *q, coreState *cs)
     switch(q->mode_type)
     {
         case MODE_PENTOMINO:
-            play_or_halt_music(q, cs, &cs->assets->track0, find_music(q->level, pentomino_music));
+            play_or_halt_music(q, cs, &cs->assets->track0, pentomino_music);
             break;
 
         case MODE_G2_MASTER:
-            play_or_halt_music(q, cs, &cs->assets->g2_track0, find_music(q->level, g2_master_music));
+            play_or_halt_music(q, cs, &cs->assets->g2_track0, g2_master_music);
             break;
 
         case MODE_G2_DEATH:
-            play_or_halt_music(q, cs, &cs->assets->g2_track0, find_music(q->level, g2_death_music));
+            play_or_halt_music(q, cs, &cs->assets->g2_track0, g2_death_music);
             break;
 
         case MODE_G3_TERROR:
-            play_or_halt_music(q, cs, &cs->assets->g3_track0, find_music(q->level, g3_terror_music));
+            play_or_halt_music(q, cs, &cs->assets->g3_track0, g3_terror_music);
             break;
 
         case MODE_G1_MASTER:
         case MODE_G1_20G:
-            play_or_halt_music(q, cs, &cs->assets->g1_track0, find_music(q->level, g1_music));
+            play_or_halt_music(q, cs, &cs->assets->g1_track0, g1_music);
             break;
 
         default:
@@ -486,6 +515,33 @@ static void update_music(qrsdata *q, coreState *cs)
     }
 }
 
+static unsigned int qs_asset_groups(int mode_type)
+{
+    unsigned int groups = ASSET_GROUP_BIT(ASSET_GROUP_BACKGROUNDS);
+
+    switch(mode_type)
+    {
+        case MODE_PENTOMINO:
+            return groups | ASSET_GROUP_BIT(ASSET_GROUP_PENTOMINO);
+
+        case MODE_G2_MASTER:
+            return groups | ASSET_GROUP_BIT(ASSET_GROUP_G2) | ASSET_GROUP_BIT(ASSET_GROUP_G2_MASTER);
+
+        case MODE_G2_DEATH:
+            return groups | ASSET_GROUP_BIT(ASSET_GROUP_G2) | ASSET_GROUP_BIT(ASSET_GROUP_G2_DEATH);
+
+        case MODE_G3_TERROR:
+            return groups | ASSET_GROUP_BIT(ASSET_GROUP_G3);
+
+        case MODE_G1_MASTER:
+        case MODE_G1_20G:
+            return groups | ASSET_GROUP_BIT(ASSET_GROUP_G1);
+
+        default:
+            return groups;
+    }
+}
+
 game_t *qs_game_create(coreState *cs, int level, unsigned int flags, int replay_id)
 {
     game_t *g = (game_t *)malloc(sizeof(game_t));
@@ -514,6 +570,7 @@ game_t *qs_game_create(coreState *cs, int level, unsigned int flags, int replay_
     q->p1 = (qrs_player *)malloc(sizeof(qrs_player));
     p = q->p1;
     p->def = NULL;
+    p->def_flags = 0;
     p->speeds = NULL;
     p->state = PSINACTIVE;
     p->x = 0;
@@ -539,7 +596,7 @@ game_t *qs_game_create(coreState *cs, int level, unsigned int flags, int replay_
             free(q->p1);
             free(q->p1counters);
             nz_timer_destroy(q->timer);
-            free(q->piecepool);
+            qrspool_destroy(q->piecepool);
             free(q);
             grid_destroy(g->field);
             free(g);
@@ -558,6 +615,9 @@ game_t *qs_game_create(coreState *cs, int level, unsigned int flags, int replay_
     q->recording = 0;
     q->playback = 0;
     q->playback_index = 0;
+    q->playback_checkpoint = 0;
+    q->desync_frame = -1;
+    q->state_hash = 0;
 
     q->is_practice = 0;
 
@@ -569,11 +629,16 @@ game_t *qs_game_create(coreState *cs, int level, unsigned int flags, int replay_
     q->garbage_row_index = 0;
     q->garbage_counter = 0;
     q->garbage_delay = 0;
+    q->num_cleared_rows = 0;
 
     q->previews[0] = NULL;
     q->previews[1] = NULL;
     q->previews[2] = NULL;
+    q->preview_flags[0] = 0;
+    q->preview_flags[1] = 0;
+    q->preview_flags[2] = 0;
     q->hold = NULL;
+    q->hold_flags = 0;
 
     q->field_x = QRS_FIELD_X;
     q->field_y = QRS_FIELD_Y;
@@ -598,6 +663,7 @@ game_t *qs_game_create(coreState *cs, int level, unsigned int flags, int replay_
     q->state_flags = 0;
 
     q->max_floorkicks = 2;
+    q->i4_wallkicks = false;
     q->lock_on_rotate = 0;
 
     request_fps(cs, 60);
@@ -703,7 +769,7 @@ game_t *qs_game_create(coreState *cs, int level, unsigned int flags, int replay_
         q->max_floorkicks = 0;
         q->special_irs = 0;
         q->lock_protect = 0;
-        q->piecepool[QRS_I4]->flags &= ~PDNOWKICK;
+        q->i4_wallkicks = true;
     }
 
     if(flags & SIMULATE_G2)
@@ -714,7 +780,7 @@ game_t *qs_game_create(coreState *cs, int level, unsigned int flags, int replay_
         q->num_previews = 1;
         q->max_floorkicks = 0;
         q->special_irs = 0;
-        q->piecepool[QRS_I4]->flags &= ~PDNOWKICK;
+        q->i4_wallkicks = true;
         request_fps(cs, G2_FPS);
     }
 
@@ -817,14 +883,9 @@ game_t *qs_game_create(coreState *cs, int level, unsigned int flags, int replay_
             q->pracdata->field_w = 10;
             q->pracdata->game_type = SIMULATE_G2;
             // q->pracdata->long_history = NULL;   // unused at the moment
-            q->pracdata->usr_seq_expand_len = 0;
-            q->pracdata->usr_seq_len = 0;
-            q->pracdata->usr_field_undo = NULL;
-            q->pracdata->usr_field_redo = NULL;
-            q->pracdata->usr_field_undo_len = 0;
-            q->pracdata->usr_field_redo_len = 0;
+            q->pracdata->seq = pracdata_seq_create();
+            q->pracdata->field = pracdata_field_create();
             q->pracdata->field_edit_in_progress = 0;
-            q->pracdata->usr_field = qrsfield_create();
             q->pracdata->palette_selection = -5;
             q->pracdata->field_selection = 0;
             q->pracdata->field_selection_vertex1_x = 0;
@@ -833,7 +894,7 @@ game_t *qs_game_create(coreState *cs, int level, unsigned int flags, int replay_
             q->pracdata->field_selection_vertex2_y = 0;
             if(flags & TETROMINO_ONLY)
             {
-                qrsfield_set_w(q->pracdata->usr_field, 10);
+                qrsfield_set_w(q->pracdata->field->usr_field, 10);
                 q->field_w = 10;
             }
 
@@ -852,6 +913,7 @@ game_t *qs_game_create(coreState *cs, int level, unsigned int flags, int replay_
             q->pracdata->invisible = 0;
             q->pracdata->infinite_floorkicks = 0;
             q->pracdata->lock_protect = -1;
+            q->pracdata->garbage_delay = 0;
             if(flags & TETROMINO_ONLY)
                 q->pracdata->piece_subset = SUBSET_TETS;
             else if(flags & PENTOMINO_ONLY)
@@ -891,6 +953,8 @@ game_t *qs_game_create(coreState *cs, int level, unsigned int flags, int replay_
         }
     }
 
+    asset_cache_acquire(cs, qs_asset_groups(q->mode_type));
+
     return g;
 }
 
@@ -948,39 +1012,44 @@ int qs_game_init(game_t *g)
         }
     }
 
-    if(q->pracdata && q->pracdata->usr_seq_len)
+    if(q->pracdata && q->pracdata->seq->usr_seq_len)
     {
-        q->previews[0] = qrspiece_cpy(q->piecepool, qs_get_usrseq_elem(q->pracdata, 0));
-        q->previews[1] = qrspiece_cpy(q->piecepool, qs_get_usrseq_elem(q->pracdata, 1));
-        q->previews[2] = qrspiece_cpy(q->piecepool, qs_get_usrseq_elem(q->pracdata, 2));
+        q->previews[0] = qrspiece_get(q->piecepool, qs_get_usrseq_elem(q->pracdata, 0));
+        q->previews[1] = qrspiece_get(q->piecepool, qs_get_usrseq_elem(q->pracdata, 1));
+        q->previews[2] = qrspiece_get(q->piecepool, qs_get_usrseq_elem(q->pracdata, 2));
 
         q->pracdata->hist_index = 2;
     }
     else
     {
-        q->previews[0] = qrspiece_cpy(q->piecepool, next1_id);
-        q->previews[1] = qrspiece_cpy(q->piecepool, next2_id);
-        q->previews[2] = qrspiece_cpy(q->piecepool, next3_id);
+        q->previews[0] = qrspiece_get(q->piecepool, next1_id);
+        q->previews[1] = qrspiece_get(q->piecepool, next2_id);
+        q->previews[2] = qrspiece_get(q->piecepool, next3_id);
     }
 
     if(q->state_flags & GAMESTATE_BRACKETS)
     {
-        if(q->previews[0])
-            q->previews[0]->flags |= PDBRACKETS;
-
-        if(q->previews[1])
-            q->previews[1]->flags |= PDBRACKETS;
-
-        if(q->previews[2])
-            q->previews[2]->flags |= PDBRACKETS;
+        q->preview_flags[0] = PDBRACKETS;
+        q->preview_flags[1] = PDBRACKETS;
+        q->preview_flags[2] = PDBRACKETS;
+    }
+    else
+    {
+        q->preview_flags[0] = 0;
+        q->preview_flags[1] = 0;
+        q->preview_flags[2] = 0;
     }
 
+    qrs_update_field_tops(g);
+    qrs_update_field_counts(g);
+
     if(q->cur_piece_qrs_id >= 18)
         p->y = ROWTOY(SPAWNY_QRS + 2);
     else
         p->y = ROWTOY(SPAWNY_QRS);
 
     p->def = NULL;
+    p->def_flags = 0;
     p->x = SPAWNX_QRS;
 
     q->p1->state = PSFALL;
@@ -998,10 +1067,7 @@ int qs_game_init(game_t *g)
         gfx_start_bg_fade_in(g->origin);
 
         if(q->mode_type == MODE_G2_DEATH)
-        {
-            // g->origin->anim_bg = g->origin->g2_bgs[q->section > 9 ? 9 : q->section];
-            // g->origin->anim_bg_old = g->origin->anim_bg;
-        }
+            gfx_set_anim_bg(g->origin, g->origin->g2_bgs[q->section > 9 ? 9 : q->section]);
     }
     else
     {
@@ -1022,29 +1088,18 @@ int qs_game_pracinit(game_t *g, int val)
     struct randomizer *qrand = q->randomizer;
     piece_id next1_id, next2_id, next3_id;
 
-    int i = 0;
-    int j = 0;
-    int cell = 0;
-
     cs->menu_input_override = 0;
 
     q->randomizer_seed = *(qrand->seedp);
     q->using_gems = false;
 
-    gridcpy(q->pracdata->usr_field, g->field);
-
-    for(i = 0; i < g->field->w; i++)
-    {
-        for(j = 0; j < g->field->h; j++)
-        {
-            cell = gridgetcell(g->field, i, j);
-            if(cell < 0 || cell == GRID_OOB)
-                continue;
+    // the field editor works on usr_field, so the live field's counts are rebuilt once here rather than on every edit
+    gridcpy(q->pracdata->field->usr_field, g->field);
+    qrs_update_field_tops(g);
+    qrs_update_field_counts(g);
 
-            if(cell & QRS_PIECE_GEM)
-                q->using_gems = true;
-        }
-    }
+    if(q->field_counts.gems)
+        q->using_gems = true;
 
     c->init = 0;
     c->lock = 0;
@@ -1067,12 +1122,17 @@ int qs_game_pracinit(game_t *g, int val)
     if(q->pracdata->brackets)
         q->state_flags |= GAMESTATE_BRACKETS;
 
-    if(q->previews[0])
-        piecedef_destroy(q->previews[0]);
-    if(q->previews[1])
-        piecedef_destroy(q->previews[1]);
-    if(q->previews[2])
-        piecedef_destroy(q->previews[2]);
+    grid_destroy(q->garbage);
+    q->garbage = NULL;
+    q->garbage_row_index = 0;
+    q->garbage_counter = 0;
+    q->garbage_delay = q->pracdata->garbage_delay;
+
+    if(q->garbage_delay)
+    {
+        q->garbage = qrs_garbage_seq_create(q->field_w);
+        q->state_flags |= GAMESTATE_RISING_GARBAGE;
+    }
 
     qrand->init(qrand, NULL);
 
@@ -1087,31 +1147,32 @@ int qs_game_pracinit(game_t *g, int val)
         next3_id = ars_to_qrs_id(next3_id);
     }
 
-    if(q->pracdata->usr_seq_len)
+    if(q->pracdata->seq->usr_seq_len)
     {
-        q->previews[0] = qrspiece_cpy(q->piecepool, qs_get_usrseq_elem(q->pracdata, 0));
-        q->previews[1] = qrspiece_cpy(q->piecepool, qs_get_usrseq_elem(q->pracdata, 1));
-        q->previews[2] = qrspiece_cpy(q->piecepool, qs_get_usrseq_elem(q->pracdata, 2));
+        q->previews[0] = qrspiece_get(q->piecepool, qs_get_usrseq_elem(q->pracdata, 0));
+        q->previews[1] = qrspiece_get(q->piecepool, qs_get_usrseq_elem(q->pracdata, 1));
+        q->previews[2] = qrspiece_get(q->piecepool, qs_get_usrseq_elem(q->pracdata, 2));
 
         q->pracdata->hist_index = 2;
     }
     else
     {
-        q->previews[0] = qrspiece_cpy(q->piecepool, next1_id);
-        q->previews[1] = qrspiece_cpy(q->piecepool, next2_id);
-        q->previews[2] = qrspiece_cpy(q->piecepool, next3_id);
+        q->previews[0] = qrspiece_get(q->piecepool, next1_id);
+        q->previews[1] = qrspiece_get(q->piecepool, next2_id);
+        q->previews[2] = qrspiece_get(q->piecepool, next3_id);
     }
 
     if(q->state_flags & GAMESTATE_BRACKETS)
     {
-        if(q->previews[0])
-            q->previews[0]->flags |= PDBRACKETS;
-
-        if(q->previews[1])
-            q->previews[1]->flags |= PDBRACKETS;
-
-        if(q->previews[2])
-            q->previews[2]->flags |= PDBRACKETS;
+        q->preview_flags[0] = PDBRACKETS;
+        q->preview_flags[1] = PDBRACKETS;
+        q->preview_flags[2] = PDBRACKETS;
+    }
+    else
+    {
+        q->preview_flags[0] = 0;
+        q->preview_flags[1] = 0;
+        q->preview_flags[2] = 0;
     }
 
     if(q->cur_piece_qrs_id >= 18)
@@ -1120,6 +1181,7 @@ int qs_game_pracinit(game_t *g, int val)
         p->y = ROWTOY(SPAWNY_QRS);
 
     p->def = NULL;
+    p->def_flags = 0;
     p->x = SPAWNX_QRS;
 
     q->p1->state = PSFALL;
@@ -1139,11 +1201,16 @@ int qs_game_quit(game_t *g)
     if(g->field)
         grid_destroy(g->field);
 
+    Mix_HaltMusic();
+    music_prefetch_cancel();
+    gfx_set_anim_bg(g->origin, NULL);
+
+    if(q)
+        asset_cache_release(g->origin, qs_asset_groups(q->mode_type));
+
     if(g->data)
         qrsdata_destroy((qrsdata *)g->data);
 
-    Mix_HaltMusic();
-
     // mostly a band-aid for quitting practice tool properly, so menu input does not take priority for regular modes
     g->origin->menu_input_override = 0;
 
@@ -1169,6 +1236,12 @@ int qs_game_frame(game_t *g)
             return 0;
     }
 
+    if(cs->settings->snapshot_bench && !q->pracdata && g->frame_counter == QS_SNAPSHOT_BENCH_FRAME)
+    {
+        qs_snapshot_benchmark(g, (unsigned int)cs->settings->snapshot_bench);
+        cs->settings->snapshot_bench = 0;    // once per run
+    }
+
     if(c->init < 120)
     {
         if(c->init == 0 || c->init == 60)
@@ -1311,7 +1384,7 @@ int qs_game_frame(game_t *g)
             for(int i = start_i; i < g->field->w - start_i; i++)
             {
                 if(gridgetcell(g->field, i, row))
-                    gridsetcell(g->field, i, row, QRS_PIECE_GARBAGE);
+                    qrs_setcell(g, i, row, QRS_PIECE_GARBAGE);
             }
         }
     }
@@ -1327,10 +1400,12 @@ int qs_game_frame(game_t *g)
             int start_i = (g->field->w - q->field_w) / 2;
             for(int i = start_i; i < g->field->w - start_i; i++)
             {
-                gridsetcell(g->field, i, 0, 0);
-                gridsetcell(g->field, i, 1, 0);
+                qrs_setcell(g, i, 0, 0);
+                qrs_setcell(g, i, 1, 0);
             }
 
+            qrs_update_field_tops(g);
+
             q->state_flags &= ~GAMESTATE_FADE_TO_CREDITS;
 
             // for testing
@@ -1351,8 +1426,10 @@ int qs_game_frame(game_t *g)
 
             for(int i = start_i; i < g->field->w - start_i; i++)
             {
-                gridsetcell(g->field, i, row, 0);
+                qrs_setcell(g, i, row, 0);
             }
+
+            qrs_update_field_tops(g);
         }
     }
 
@@ -1472,7 +1549,7 @@ int qs_game_frame(game_t *g)
                 {
                     fade_counter--;
                     SET_PIECE_FADE_COUNTER(val, fade_counter);
-                    gridsetcell(g->field, i, j, val);
+                    qrs_setcell(g, i, j, val);
                 }
             }
         }
@@ -1495,9 +1572,12 @@ int qs_game_frame(game_t *g)
         }
     }
 
+    // thresholds were tuned against grid_cells_filled(), which counted the wall cells too
+    int cells = q->field_counts.cells + (QRS_FIELD_W - q->field_w) * QRS_FIELD_H;
+
     if(!q->pracdata && q->is_recovering && q->game_type == 0)
     {
-        if(grid_cells_filled(g->field) <= 85)
+        if(cells <= 85)
         {
             q->recoveries++;
             q->last_medal_re_timestamp = g->frame_counter;
@@ -1525,7 +1605,7 @@ int qs_game_frame(game_t *g)
             }
         }
     }
-    else if(grid_cells_filled(g->field) >= 170)
+    else if(cells >= 170)
         q->is_recovering = 1;
 
     if(!q->pracdata && q->mode_type == MODE_G3_TERROR)
@@ -1935,9 +2015,8 @@ int qs_process_lockflash(game_t *g)
             q->combo += 2 * n - 2;
             bool bravo = false;
 
-            int cells = grid_cells_filled(g->field);
-            // slightly convoluted calculation, need to do this to account for the QRS_WALL blocks on the sides
-            if(cells == (g->field->w * g->field->h) - (q->field_w * QRS_FIELD_H))
+            // the rows that were just cleared are still in the field (as -2) until qrs_dropfield()
+            if(q->field_counts.cells == n * q->field_w)
                 bravo = true;
 
             switch(n)
@@ -2432,6 +2511,9 @@ int qs_process_lockflash(game_t *g)
                     {
                         cs->bg = (&cs->assets->bg0 + q->section)->tex;
                     }
+
+                    if(q->mode_type == MODE_G2_DEATH)
+                        gfx_set_anim_bg(cs, cs->g2_bgs[q->section > 9 ? 9 : q->section]);
                 }
             }
             else if(q->level == 999 && q->lvlinc)
@@ -2549,11 +2631,7 @@ so there aren't so many awkward overlapping functions
 need to break this up into multiple functions which each update exactly one
 thing
 
-split up pieceseq parser into: parsing function, expansion function, and
-get_usrseq_elem
-
-get_elem should return failure if q->pracdata->usr_seq_expand is NULL and it
-should not modify state
+split the pieceseq parser out of here (qs_compile_usrseq() already takes its output)
 */
 
 int qs_update_pracdata(coreState *cs)
@@ -2563,6 +2641,7 @@ int qs_update_pracdata(coreState *cs)
 
     qrsdata *q = (qrsdata *)cs->p1game->data;
     struct pracdata *d = q->pracdata;
+    struct pracdata_seq *seq = NULL;
     menudata *md = (menudata *)cs->menu->data;
     string seqStr;
     char name_str[3] = {0, 0, 0};
@@ -2599,7 +2678,7 @@ int qs_update_pracdata(coreState *cs)
             q->hold_enabled = 0;
             q->max_floorkicks = 2;
             q->lock_protect = 1;
-            q->piecepool[QRS_I4]->flags &= ~PDNOWKICK;
+            q->i4_wallkicks = true;
             q->tetromino_only = 0;
             q->pentomino_only = 0;
             request_fps(cs, 60);
@@ -2614,7 +2693,7 @@ int qs_update_pracdata(coreState *cs)
             q->hold_enabled = 0;
             q->max_floorkicks = 0;
             q->lock_protect = 0;
-            q->piecepool[QRS_I4]->flags |= PDNOWKICK;
+            q->i4_wallkicks = false;
             q->tetromino_only = 1;
             q->pentomino_only = 0;
             request_fps(cs, 60);
@@ -2629,7 +2708,7 @@ int qs_update_pracdata(coreState *cs)
             q->hold_enabled = 0;
             q->max_floorkicks = 0;
             q->lock_protect = 1;
-            q->piecepool[QRS_I4]->flags |= PDNOWKICK;
+            q->i4_wallkicks = false;
             q->tetromino_only = 1;
             q->pentomino_only = 0;
             request_fps(cs, G2_FPS);
@@ -2644,7 +2723,7 @@ int qs_update_pracdata(coreState *cs)
             q->hold_enabled = 1;
             q->max_floorkicks = 1;
             q->lock_protect = 1;
-            q->piecepool[QRS_I4]->flags &= ~PDNOWKICK;
+            q->i4_wallkicks = true;
             q->tetromino_only = 1;
             q->pentomino_only = 0;
             request_fps(cs, 60);
@@ -2654,6 +2733,7 @@ int qs_update_pracdata(coreState *cs)
     }
 
     q->hold = NULL;
+    q->hold_flags = 0;
 
     // and now for the hackiest check ever to see if we need to update the usr_seq
 
@@ -3031,51 +3111,39 @@ int qs_update_pracdata(coreState *cs)
     }
 
 end_sequence_proc:
+    seq = d->seq;
     for(i = 0; i < num; i++)
-        d->usr_sequence[i] = piece_seq[i];
+        seq->usr_sequence[i] = piece_seq[i];
 
-    d->usr_seq_len = num;
-    d->usr_seq_expand_len = 0;
+    seq->usr_seq_len = num;
+    qs_compile_usrseq(seq);
 
     /**/
 
     qrsfield_set_w(cs->p1game->field, q->field_w);
-    qrsfield_set_w(q->pracdata->usr_field, q->field_w);
-
-    for(i = 0; i < d->usr_field_undo_len; i++)
-        qrsfield_set_w(q->pracdata->usr_field_undo[i], q->field_w);
-
-    for(i = 0; i < d->usr_field_redo_len; i++)
-        qrsfield_set_w(q->pracdata->usr_field_redo[i], q->field_w);
+    qrsfield_set_w(q->pracdata->field->usr_field, q->field_w);
 
     d->field_selection = 0;
 
     // process randomizer seed entry...
 
-    // q->previews are expected to be destroyed and re-allocated as needed
-
-    if(q->previews[0])
-        piecedef_destroy(q->previews[0]);
-    if(q->previews[1])
-        piecedef_destroy(q->previews[1]);
-    if(q->previews[2])
-        piecedef_destroy(q->previews[2]);
+    // q->previews point into q->piecepool, so they are simply dealt again
 
     q->previews[0] = NULL;
     q->previews[1] = NULL;
     q->previews[2] = NULL;
 
-    if(q->pracdata->usr_seq_len)
+    if(q->pracdata->seq->usr_seq_len)
     {
-        q->previews[0] = qrspiece_cpy(q->piecepool, qs_get_usrseq_elem(d, 0));
-        q->previews[1] = qrspiece_cpy(q->piecepool, qs_get_usrseq_elem(d, 1));
-        q->previews[2] = qrspiece_cpy(q->piecepool, qs_get_usrseq_elem(d, 2));
+        q->previews[0] = qrspiece_get(q->piecepool, qs_get_usrseq_elem(d, 0));
+        q->previews[1] = qrspiece_get(q->piecepool, qs_get_usrseq_elem(d, 1));
+        q->previews[2] = qrspiece_get(q->piecepool, qs_get_usrseq_elem(d, 2));
     }
     else
     {
-        q->previews[0] = qrspiece_cpy(q->piecepool, q->randomizer->lookahead(q->randomizer, 1));
-        q->previews[1] = qrspiece_cpy(q->piecepool, q->randomizer->lookahead(q->randomizer, 2));
-        q->previews[2] = qrspiece_cpy(q->piecepool, q->randomizer->lookahead(q->randomizer, 3));
+        q->previews[0] = qrspiece_get(q->piecepool, q->randomizer->lookahead(q->randomizer, 1));
+        q->previews[1] = qrspiece_get(q->piecepool, q->randomizer->lookahead(q->randomizer, 2));
+        q->previews[2] = qrspiece_get(q->piecepool, q->randomizer->lookahead(q->randomizer, 3));
     }
 
     if(d->brackets)
@@ -3090,237 +3158,132 @@ end_sequence_proc:
 
     if(q->state_flags & GAMESTATE_BRACKETS)
     {
-        if(q->previews[0])
-            q->previews[0]->flags |= PDBRACKETS;
-
-        if(q->previews[1])
-            q->previews[1]->flags |= PDBRACKETS;
-
-        if(q->previews[2])
-            q->previews[2]->flags |= PDBRACKETS;
+        q->preview_flags[0] = PDBRACKETS;
+        q->preview_flags[1] = PDBRACKETS;
+        q->preview_flags[2] = PDBRACKETS;
     }
     else
     {
-        if(q->previews[0])
-            q->previews[0]->flags &= ~PDBRACKETS;
-
-        if(q->previews[1])
-            q->previews[1]->flags &= ~PDBRACKETS;
-
-        if(q->previews[2])
-            q->previews[2]->flags &= ~PDBRACKETS;
+        q->preview_flags[0] = 0;
+        q->preview_flags[1] = 0;
+        q->preview_flags[2] = 0;
     }
 
     return 0;
 }
 
-// TODO: clean this function up, especially the parser + expander, and use more established terminology
-int qs_get_usrseq_elem(struct pracdata *d, int index)
+/* turns usr_sequence into runs of pieces:
+   - plain pieces: a run played once (neighbouring ones share a run)
+   - SEQUENCE_REPEAT_START .. SEQUENCE_REPEAT_END n: the group, played n times; a group left open at the end plays once
+   - SEQUENCE_REPEAT_START .. SEQUENCE_REPEAT_END SEQUENCE_REPEAT_INF: the group forever, ignoring anything after it */
+int qs_compile_usrseq(struct pracdata_seq *s)
 {
-    int *seq = d->usr_sequence;
-    int expand[4000];
-    int expand_count = 0;
-
-    int rpt_start = 0;
-    int rpt_end = 0;
-    int rpt_len = 0;
-    int rpt_count = 0;
-    int rpt = 0;
-    int inf_rpt_len = 0;
-    int inf_start = 0;
-
-    int inf = 0;
+    if(!s)
+        return -1;
 
+    int *seq = s->usr_sequence;
+    struct usrseq_op *op = NULL;
+    int start = 0;
+    int len = 0;
+    int count = 0;
     int i = 0;
     int j = 0;
-    int k = 0;
-    int val = 0;
-    int complex = 0;
-
-    if(d->usr_seq_expand_len)
-    {
-        for(i = 0; i < d->usr_seq_expand_len; i++)
-        {
-            if(d->usr_seq_expand[i] & SEQUENCE_REPEAT_INF)
-            {
-                inf = 1;
-                rpt_start = i;
-                inf_rpt_len = d->usr_seq_expand_len - rpt_start;
-            }
-        }
-
-        if(inf)
-        {
-            if(index < rpt_start)
-            {
-                val = d->usr_seq_expand[index] & 0b11111;
-            }
-            else
-            {
-                if(inf_rpt_len > 1)
-                    index = (index - rpt_start) % inf_rpt_len;
-                else
-                    index = 0;
-
-                val = d->usr_seq_expand[rpt_start + index] & 0b11111;
-            }
-        }
-        else
-        {
-            if(index > d->usr_seq_expand_len - 1)
-                val = USRSEQ_ELEM_OOB;
-            else
-                val = d->usr_seq_expand[index] & 0b11111;
-        }
 
-        return val;
-    }
-
-    if(!d->usr_seq_len)
-    {
-        d->usr_seq_expand_len = 0;
-        return USRSEQ_ELEM_OOB;
-    }
+    free(s->usr_seq_ops);
+    s->usr_seq_ops = NULL;
+    s->usr_seq_num_ops = 0;
 
-    for(i = 0; i < index && i < d->usr_seq_len; i++)
-    {
-        if(!IS_QRS_PIECE(seq[i]))
-            complex = 1;
-    }
+    if(!s->usr_seq_len)
+        return 0;
 
-    if(!complex && index < d->usr_seq_len)
-    {
-        if(IS_QRS_PIECE(seq[index]))
-            return seq[index];
-    }
+    // every op takes at least one element
+    s->usr_seq_ops = (struct usrseq_op *)malloc(s->usr_seq_len * sizeof(struct usrseq_op));
 
-    for(i = 0;; i++)
+    while(i < s->usr_seq_len)
     {
-        if(i >= d->usr_seq_len || expand_count > 3500)
-        {
-            // 3500 is an arbitrary limit to prevent taking up too much memory for little benefit
-            break;
-        }
-
-        val = seq[i];
-        if(rpt)
+        if(!(seq[i] & SEQUENCE_REPEAT_START))
         {
-            /* rpt = 1 implies we encountered the beginning of a grouped subsequence, where groups are assumed
-            to have a rep count specified at the end */
-            if(val & SEQUENCE_REPEAT_END || i == d->usr_seq_len - 1)
+            if(op && op->count == 1 && op->first + op->len == i)
+                op->len++;
+            else
             {
-                rpt = 0;
-                rpt_end = i;
-                rpt_len = rpt_end - rpt_start + 1; // length of grouped subsequence
-                i++;                               // next element of the sequence is either a repetition count or beyond the end of the sequence
+                op = &s->usr_seq_ops[s->usr_seq_num_ops++];
+                op->first = i;
+                op->len = 1;
+                op->count = 1;
+                op->start = start;
+            }
 
-                if(i != d->usr_seq_len && seq[i] == SEQUENCE_REPEAT_INF)
-                {
-                    // ^^ bound check must come first to prevent seq[i] from creating UB
-                    inf = 1;
-                    inf_rpt_len = rpt_len;
-                    inf_start = rpt_start;
-                    expand_count += rpt_len;
-                    for(k = 0; k < rpt_len; k++)
-                    {
-                        /* seq[blah] & 0b11111 zeroes other flags on the piece;
-                        first repeated element gets repeat_inf flag;
-                        expanded sequence is cut off after the infinitely repeating group and this expansion loop ends */
+            start++;
+            i++;
+            continue;
+        }
 
-                        expand[expand_count - rpt_len + k] = (seq[rpt_start + k] & 0b11111) | (!k ? SEQUENCE_REPEAT_INF : 0);
-                    }
+        // the group runs to the first element marked as its end, or to the end of the sequence
+        for(j = i; j < s->usr_seq_len - 1 && !(seq[j] & SEQUENCE_REPEAT_END); j++)
+            ;
 
-                    break;
-                }
-                else
-                {
-                    // dealing with finite repetition or open-ended grouped subsequence
+        len = j - i + 1;
 
-                    if(i == d->usr_seq_len)
-                        rpt_count = 1;
-                    // ^^ force open-ended group to 1 repetition (same as if there was no grouping)
+        // the element after the group is its repetition count
+        if(j + 1 >= s->usr_seq_len)
+            count = 1;
+        else if(seq[j + 1] == SEQUENCE_REPEAT_INF)
+            count = USRSEQ_COUNT_INF;
+        else if(seq[j + 1] > USRSEQ_RPTCOUNT_MAX)
+            count = USRSEQ_RPTCOUNT_MAX;
+        else
+            count = seq[j + 1];
 
-                    else
-                    {
-                        if(seq[i] > USRSEQ_RPTCOUNT_MAX) // last-minute bounding of repetition count to something reasonable
-                            rpt_count = USRSEQ_RPTCOUNT_MAX;
-                        else
-                            rpt_count = seq[i];
-                    }
+        if(count)
+        {
+            op = &s->usr_seq_ops[s->usr_seq_num_ops++];
+            op->first = i;
+            op->len = len;
+            op->count = count;
+            op->start = start;
 
-                    for(k = 0; k < rpt_count; k++)
-                    { // expand entire repetition to sequence of pieces with no special flags
-                        for(j = 0; j < rpt_len; j++)
-                        {
-                            expand[expand_count + k * rpt_len + j] = seq[rpt_start + j] & 0b11111;
-                        }
-                    }
+            if(count == USRSEQ_COUNT_INF)
+                break;
 
-                    expand_count += rpt_count * rpt_len;
-                    rpt = 0; // we are done with this grouped subsequence
-                }
-            }
-        }
-        else
-        {
-            if(val & SEQUENCE_REPEAT_START)
-            {
-                rpt_start = i;
-                rpt = 1;
-                if(val & SEQUENCE_REPEAT_END || i == d->usr_seq_len - 1)
-                {
-                    i--;      // hacky way for the loop to go into the if(rpt) branch and handle these edge cases
-                    continue; // the i-- ensures the loop reads the additional flags on this element/doesn't go OOB
-                }
-            }
-            else
-            { // no expansion to be done
-                expand_count++;
-                expand[expand_count - 1] = seq[i] & 0b11111;
-            }
+            start += len * count;
         }
+
+        i = j + 2;
     }
 
-    // end of expansion loop
+    return 0;
+}
 
-    if(inf)
-    {
-        if(index < inf_start)
-        { // index is of the piece we want to return to the function caller
-            val = expand[index] & 0b11111;
-        }
-        else
-        {
-            if(inf_rpt_len > 1)
-            {
-                // collapse an arbitrarily large index value to a relative one that fits in the array bounds
-                index = (index - inf_start) % inf_rpt_len;
-            }
-            else
-                index = 0;
+int qs_get_usrseq_elem(struct pracdata *d, int index)
+{
+    struct pracdata_seq *s = d->seq;
+    struct usrseq_op *op = NULL;
+    int lo = 0;
+    int hi = s->usr_seq_num_ops - 1;
+    int mid = 0;
 
-            val = expand[inf_start + index] & 0b11111;
-        }
-    }
-    else
+    if(index < 0 || !s->usr_seq_num_ops)
+        return USRSEQ_ELEM_OOB;
+
+    // last op starting at or before index
+    while(lo < hi)
     {
-        if(index < expand_count)
-            val = expand[index] & 0b11111;
+        mid = (lo + hi + 1) / 2;
+        if(s->usr_seq_ops[mid].start <= index)
+            lo = mid;
         else
-            val = USRSEQ_ELEM_OOB;
+            hi = mid - 1;
     }
 
-    // printf("Expanded sequence:");
-    // for(i = 0; i < expand_count; i++) { printf(" %d", expand[i]); }
-    // printf("\n");
-
-    // updating the pracdata's expanded sequence field so we don't have to waste time expanding it later unless it changes
-    for(i = 0; i < expand_count; i++)
-        d->usr_seq_expand[i] = expand[i];
+    op = &s->usr_seq_ops[lo];
+    if(op->start > index)
+        return USRSEQ_ELEM_OOB;
 
-    d->usr_seq_expand_len = expand_count;
+    if(op->count != USRSEQ_COUNT_INF && index - op->start >= op->len * op->count)
+        return USRSEQ_ELEM_OOB;
 
-    return val;
+    return s->usr_sequence[op->first + (index - op->start) % op->len] & 0b11111;
 }
 
 // return value: 0 success, -1 invalid argument(s), 1 no next piece to deal to the player
@@ -3333,11 +3296,8 @@ int qs_initnext(game_t *g, qrs_player *p, unsigned int flags)
     qrsdata *q = (qrsdata *)(g->data);
     struct randomizer *qrand = q->randomizer;
 
-    int i = 0;
-    int j = 0;
     piece_id t = 0;
     int rc = 0;
-    int cell = 0;
 
     q->lock_on_rotate = 0;
     q->p1counters->floorkicks = 0;
@@ -3352,7 +3312,7 @@ int qs_initnext(game_t *g, qrs_player *p, unsigned int flags)
         // we don't want the game to terminate while the player is controlling a piece
         // edge case where this is relevant: player uses hold with no held piece, at last piece in user seq
 
-        if(q->pracdata && q->pracdata->usr_seq_len)
+        if(q->pracdata && q->pracdata->seq->usr_seq_len)
         {
             if(qs_get_usrseq_elem(q->pracdata, q->pracdata->hist_index + 1) == USRSEQ_ELEM_OOB)
             {
@@ -3363,28 +3323,14 @@ int qs_initnext(game_t *g, qrs_player *p, unsigned int flags)
 
     if(q->using_gems)
     {
-        bool gems_in_field = false;
-        for(i = 0; i < g->field->w; i++)
-        {
-            for(j = 0; j < g->field->h; j++)
-            {
-                cell = gridgetcell(g->field, i, j);
-                if(cell < 0 || cell == GRID_OOB)
-                    continue;
-
-                if(cell & QRS_PIECE_GEM)
-                    gems_in_field = true;
-            }
-        }
-
-        if(gems_in_field == false)
+        if(!q->field_counts.gems)
         {
             log_info("No gems left, terminating.\n");
             return QSGAME_SHOULD_TERMINATE;
         }
     }
 
-    if(q->pracdata && q->pracdata->usr_seq_len)
+    if(q->pracdata && q->pracdata->seq->usr_seq_len)
     {
         q->pracdata->hist_index++;
         rc = qs_get_usrseq_elem(q->pracdata, q->pracdata->hist_index);
@@ -3401,9 +3347,8 @@ int qs_initnext(game_t *g, qrs_player *p, unsigned int flags)
             t = ars_to_qrs_id(t);
     }
 
-    if(p->def)
-        piecedef_destroy(p->def);
     p->def = q->previews[0];
+    p->def_flags = q->preview_flags[0];
 
     if(p->def)
         q->cur_piece_qrs_id = p->def->qrs_id;
@@ -3412,14 +3357,12 @@ int qs_initnext(game_t *g, qrs_player *p, unsigned int flags)
 
     q->previews[0] = q->previews[1];
     q->previews[1] = q->previews[2];
-    q->previews[2] = qrspiece_cpy(q->piecepool, t);
+    q->previews[2] = qrspiece_get(q->piecepool, t);
     // printf("New piecedef to deal out: %lx with ID %d\n", q->previews[2], t);
 
-    if(q->state_flags & GAMESTATE_BRACKETS)
-    {
-        if(q->previews[2])
-            q->previews[2]->flags |= PDBRACKETS;
-    }
+    q->preview_flags[0] = q->preview_flags[1];
+    q->preview_flags[1] = q->preview_flags[2];
+    q->preview_flags[2] = (q->state_flags & GAMESTATE_BRACKETS) ? PDBRACKETS : 0;
 
     if(q->previews[0])
     {
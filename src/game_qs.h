@@ -146,6 +146,7 @@ int qs_process_lineare(game_t *g);
 
 int qrs_game_is_inactive(coreState *cs);
 int qs_update_pracdata(coreState *cs);
+int qs_compile_usrseq(struct pracdata_seq *s);
 int qs_get_usrseq_elem(struct pracdata *d, int index);
 
 int qs_initnext(game_t *g, qrs_player *p, unsigned int flags);
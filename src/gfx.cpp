@@ -6,6 +6,7 @@
 #include <stdio.h>
 
 #include "core.h"
+#include "anim_bg.h"
 #include "game_qs.h"
 #include "gfx.h"
 #include "gfx_structures.h"
@@ -47,10 +48,9 @@ int gfx_piece_colors[25] =
 };
 */
 
-bool img_load(gfx_image *img, const char *path_without_ext, coreState *cs)
+// safe to call from any thread; only the texture upload has to happen on the render thread
+SDL_Surface *img_load_surface(const char *path_without_ext)
 {
-    img->tex = NULL;
-
     SDL_Surface *s = NULL;
 
     bstring path = bfromcstr(path_without_ext);
@@ -66,6 +66,20 @@ bool img_load(gfx_image *img, const char *path_without_ext, coreState *cs)
         bdestroy(path);
     }
 
+    return s;
+}
+
+// from an asset pack window or any other stream; closes rw
+SDL_Surface *img_load_surface_rw(SDL_RWops *rw)
+{
+    return IMG_Load_RW(rw, 1);
+}
+
+// takes ownership of s
+bool img_load_from_surface(gfx_image *img, SDL_Surface *s, coreState *cs)
+{
+    img->tex = NULL;
+
     if(s)
     {
         img->tex = SDL_CreateTextureFromSurface(cs->screen.renderer, s);
@@ -75,10 +89,17 @@ bool img_load(gfx_image *img, const char *path_without_ext, coreState *cs)
     return img->tex != NULL;
 }
 
+bool img_load(gfx_image *img, const char *path_without_ext, coreState *cs)
+{
+    return img_load_from_surface(img, img_load_surface(path_without_ext), cs);
+}
+
 void img_destroy(gfx_image *img)
 {
     if(img->tex)
         SDL_DestroyTexture(img->tex);
+
+    img->tex = NULL;
 }
 
 png_monofont *monofont_tiny = NULL;
@@ -243,50 +264,58 @@ int gfx_start_bg_fade_in(coreState *cs)
     return 0;
 }
 
+int gfx_set_anim_bg(coreState *cs, struct anim_bg *a)
+{
+    if(!cs)
+        return -1;
+
+    // a change of mind before the last one got going
+    if(cs->anim_bg_next && cs->anim_bg_next != a)
+        anim_bg_stop(cs->anim_bg_next);
+    cs->anim_bg_next = NULL;
+
+    if(cs->anim_bg == a)
+        return 0;
+
+    if(!a)
+    {
+        anim_bg_stop(cs->anim_bg);
+        cs->anim_bg = NULL;
+        return 0;
+    }
+
+    // frame 0 is decoded off the main thread; whatever's up now stays until it's in (see gfx_drawbg())
+    if(anim_bg_start(a))
+        return 1;
+
+    cs->anim_bg_next = a;
+    return 0;
+}
+
 int gfx_drawbg(coreState *cs)
 {
-    // SDL_Texture *bg_darken = (asset_by_name(cs, "bg_darken"))->data;
-    // SDL_Texture *anim_bg_frame = NULL;
-    // bstring asset_name = NULL;
+    SDL_Texture *anim_bg_frame_tex = NULL;
     Uint8 r = 0;
     Uint8 g = 0;
     Uint8 b = 0;
-    // Uint8 a;
-
-    /*if(cs->anim_bg || cs->anim_bg_old) {
-        SDL_SetTextureColorMod(bg_darken, 0, 0, 0);
-        if(cs->anim_bg != cs->anim_bg_old) {
-            SDL_GetTextureAlphaMod(bg_darken, &a);
-            if(a < 255) {
-                if(a < 255 - BG_FADE_RATE)
-                    a += BG_FADE_RATE;
-                else
-                    a = 255;
-            } else {
 
-            }
-        } else {
-            asset_name = bformat("%s/%05d", cs->anim_bg->name->data, cs->anim_bg->counter/cs->anim_bg->frame_multiplier);
-            anim_bg_frame = (asset_by_name(cs, asset_name->data))->data;
-            //printf("Drawing %s\n", asset_name->data);
-
-            SDL_RenderCopy(cs->screen.renderer, anim_bg_frame, NULL, NULL);
-        //}
-
-        if(cs->anim_bg) {
-            cs->anim_bg->counter++;
-            if(cs->anim_bg->counter == cs->anim_bg->num_frames*cs->anim_bg->frame_multiplier)
-                cs->anim_bg->counter = 0;
-        }
+    if(cs->anim_bg_next && anim_bg_ready(cs->anim_bg_next))
+    {
+        // only the one being shown holds any frames
+        anim_bg_stop(cs->anim_bg);
+        cs->anim_bg = cs->anim_bg_next;
+        cs->anim_bg_next = NULL;
+    }
 
-      if(cs->anim_bg_old && cs->anim_bg != cs->anim_bg_old) {
-            cs->anim_bg_old->counter++;
-            if(cs->anim_bg_old->counter == cs->anim_bg->num_frames*cs->anim_bg->frame_multiplier)
-                cs->anim_bg_old->counter = 0;
+    if(cs->anim_bg)
+    {
+        anim_bg_frame_tex = anim_bg_frame(cs->anim_bg, cs->screen.renderer);
+        if(anim_bg_frame_tex)
+        {
+            SDL_RenderCopy(cs->screen.renderer, anim_bg_frame_tex, NULL, NULL);
+            return 0;
         }
-
-        return 0;
-    }*/
+    }
 
     if(cs->bg != cs->bg_old)
     {
@@ -1275,7 +1304,7 @@ int gfx_drawtext_partial(coreState *cs, bstring text, int pos, int len, int x, i
     return 0;
 }
 
-int gfx_drawpiece(coreState *cs, grid_t *field, int field_x, int field_y, piecedef *pd, unsigned int flags, int orient, int x, int y, Uint32 rgba)
+int gfx_drawpiece(coreState *cs, grid_t *field, int field_x, int field_y, const piecedef *pd, unsigned int flags, int orient, int x, int y, Uint32 rgba)
 {
     if(!cs || !pd)
         return -1;
@@ -1339,10 +1368,10 @@ int gfx_drawpiece(coreState *cs, grid_t *field, int field_x, int field_y, pieced
                 else
                     dest.y = y + (j * size);
 
-                if(flags & DRAWPIECE_BRACKETS || pd->flags & PDBRACKETS)
+                if(flags & DRAWPIECE_BRACKETS)
                     src.x = 30 * size;
 
-                if(flags & DRAWPIECE_LOCKFLASH && !(flags & DRAWPIECE_BRACKETS) && !(pd->flags & PDBRACKETS))
+                if(flags & DRAWPIECE_LOCKFLASH && !(flags & DRAWPIECE_BRACKETS))
                 {
                     src.x = 26 * size;
                     cell_x = (x - field_x) / 16 + i - 1;
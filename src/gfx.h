@@ -77,6 +77,7 @@ int gfx_init(coreState *cs);
 void gfx_quit(coreState *cs);
 
 int gfx_start_bg_fade_in(coreState *cs);
+int gfx_set_anim_bg(coreState *cs, struct anim_bg *a);    // NULL to go back to bg
 int gfx_drawbg(coreState *cs);
 int gfx_draw_emergency_bg_darken(coreState *cs);
 
@@ -101,7 +102,7 @@ int gfx_drawkeys(coreState *cs, struct keyflags *k, int x, int y, Uint32 rgba);
 int gfx_drawtext(coreState *cs, std::string text, int x, int y, png_monofont *font, struct text_formatting *fmt);
 int gfx_drawtext(coreState *cs, bstring text, int x, int y, png_monofont *font, struct text_formatting *fmt);
 int gfx_drawtext_partial(coreState *cs, bstring text, int pos, int len, int x, int y, png_monofont *font, struct text_formatting *fmt);
-int gfx_drawpiece(coreState *cs, grid_t *field, int field_x, int field_y, piecedef *pd, unsigned int flags, int orient, int x, int y, Uint32 rgba);
+int gfx_drawpiece(coreState *cs, grid_t *field, int field_x, int field_y, const piecedef *pd, unsigned int flags, int orient, int x, int y, Uint32 rgba);
 int gfx_drawtimer(coreState *cs, nz_timer *t, int x, Uint32 rgba);
 
 int SDL_RenderCopyVita(SDL_Renderer* renderer, SDL_Texture* texture, const SDL_Rect* srcrect, const SDL_Rect* dstrect);
@@ -45,6 +45,15 @@ int piece_colors[26] =
 };
 // clang-format on
 
+// pool piecedefs are shared, so per-instance flags (PDBRACKETS) are carried alongside them
+static unsigned int drawpiece_instance_flags(unsigned int flags, unsigned int pd_flags)
+{
+    if(pd_flags & PDBRACKETS)
+        return (flags & ~DRAWPIECE_LOCKFLASH) | DRAWPIECE_BRACKETS;
+
+    return flags;
+}
+
 int gfx_drawqs(game_t *g)
 {
     if(!g)
@@ -55,7 +64,7 @@ int gfx_drawqs(game_t *g)
     coreState *cs = g->origin;
     qrsdata *q = (qrsdata *)(g->data);
 
-    piecedef *pd_current = q->p1->def;
+    const piecedef *pd_current = q->p1->def;
 
     unsigned int drawpiece_next1_flags = DRAWPIECE_PREVIEW;
     if(q->previews[0])
@@ -99,8 +108,6 @@ int gfx_drawqs(game_t *g)
     int hold_x = preview1_x - 8 * 6;
     int hold_y = preview2_y - 12;
 
-    int y_bkp = 0;
-    int s_bkp = 0;
 
     double mspf = 1000.0 * (1.0 / cs->fps);
     int cpu_time_percentage = (int)(100.0 * ((mspf - cs->avg_sleep_ms_recent) / mspf));
@@ -149,13 +156,13 @@ int gfx_drawqs(game_t *g)
     {
         if(q->pracdata->paused == QRS_FIELD_EDIT)
         {
-            gfx_drawqrsfield(cs, q->pracdata->usr_field, MODE_PENTOMINO, DRAWFIELD_GRID | DRAWFIELD_NO_OUTLINE, x, y);
+            gfx_drawqrsfield(cs, q->pracdata->field->usr_field, MODE_PENTOMINO, DRAWFIELD_GRID | DRAWFIELD_NO_OUTLINE, x, y);
             if(q->pracdata->field_selection)
                 gfx_drawfield_selection(g, q->pracdata);
 
-            if(q->pracdata->usr_field_undo_len)
+            if(q->pracdata->field->history->num_undo)
             {
-                undo_len = strtools::format("%d", q->pracdata->usr_field_undo_len);
+                undo_len = strtools::format("%d", q->pracdata->field->history->num_undo);
 
                 gfx_drawtext(cs, undo, QRS_FIELD_X + 32, QRS_FIELD_Y + 23 * 16, monofont_square, NULL);
                 gfx_drawtext(cs, undo_len, QRS_FIELD_X + 32, QRS_FIELD_Y + 24 * 16, monofont_square, NULL);
@@ -168,9 +175,9 @@ int gfx_drawqs(game_t *g)
                 SDL_RenderCopy(cs->screen.renderer, font, &src, &dest);
             }
 
-            if(q->pracdata->usr_field_redo_len)
+            if(q->pracdata->field->history->num_redo)
             {
-                redo_len = strtools::format("%d", q->pracdata->usr_field_redo_len);
+                redo_len = strtools::format("%d", q->pracdata->field->history->num_redo);
 
                 gfx_drawtext(cs, redo, QRS_FIELD_X + 9 * 16, QRS_FIELD_Y + 23 * 16, monofont_square, NULL);
                 gfx_drawtext(cs, redo_len, QRS_FIELD_X + 13 * 16 - 16 * (redo_len.length()), QRS_FIELD_Y + 24 * 16, monofont_square, NULL);
@@ -183,7 +190,7 @@ int gfx_drawqs(game_t *g)
                 SDL_RenderCopy(cs->screen.renderer, font, &src, &dest);
             }
 
-            if(q->pracdata->usr_seq_len)
+            if(q->pracdata->seq->usr_seq_len)
             {
                 if(qs_get_usrseq_elem(q->pracdata, 0) == QRS_I4 || qs_get_usrseq_elem(q->pracdata, 0) == QRS_I)
                     drawpiece_next1_flags = DRAWPIECE_PREVIEW | DRAWPIECE_IPREVIEW;
@@ -193,11 +200,11 @@ int gfx_drawqs(game_t *g)
                 // gfx_drawtext(cs, next, 48 - 32 + QRS_FIELD_X, 26, 0, 0xFFFFFF8C, 0x0000008C);
 
                 if(q->num_previews > 0)
-                    gfx_drawpiece(cs, g->field, x, y, q->previews[0], drawpiece_next1_flags, FLAT, preview1_x, preview1_y, RGBA_DEFAULT);
+                    gfx_drawpiece(cs, g->field, x, y, q->previews[0], drawpiece_instance_flags(drawpiece_next1_flags, q->preview_flags[0]), FLAT, preview1_x, preview1_y, RGBA_DEFAULT);
                 if(q->num_previews > 1)
-                    gfx_drawpiece(cs, g->field, x, y, q->previews[1], DRAWPIECE_PREVIEW | DRAWPIECE_SMALL, FLAT, preview2_x, preview2_y, RGBA_DEFAULT);
+                    gfx_drawpiece(cs, g->field, x, y, q->previews[1], drawpiece_instance_flags(DRAWPIECE_PREVIEW | DRAWPIECE_SMALL, q->preview_flags[1]), FLAT, preview2_x, preview2_y, RGBA_DEFAULT);
                 if(q->num_previews > 2)
-                    gfx_drawpiece(cs, g->field, x, y, q->previews[2], DRAWPIECE_PREVIEW | DRAWPIECE_SMALL, FLAT, preview3_x, preview3_y, RGBA_DEFAULT);
+                    gfx_drawpiece(cs, g->field, x, y, q->previews[2], drawpiece_instance_flags(DRAWPIECE_PREVIEW | DRAWPIECE_SMALL, q->preview_flags[2]), FLAT, preview3_x, preview3_y, RGBA_DEFAULT);
             }
 
             for(i = 0; i < 18; i++)
@@ -582,13 +589,38 @@ int gfx_drawqs(game_t *g)
         }
 
         if(q->num_previews > 0)
-            gfx_drawpiece(cs, g->field, x, y, q->previews[0], drawpiece_flags | drawpiece_next1_flags, FLAT, preview1_x, preview1_y, RGBA_DEFAULT);
+            gfx_drawpiece(cs,
+                          g->field,
+                          x,
+                          y,
+                          q->previews[0],
+                          drawpiece_instance_flags(drawpiece_flags | drawpiece_next1_flags, q->preview_flags[0]),
+                          FLAT,
+                          preview1_x,
+                          preview1_y,
+                          RGBA_DEFAULT);
         if(q->num_previews > 1)
-            gfx_drawpiece(
-                cs, g->field, x, y, q->previews[1], drawpiece_flags | DRAWPIECE_PREVIEW | DRAWPIECE_SMALL, FLAT, preview2_x, preview2_y, RGBA_DEFAULT);
+            gfx_drawpiece(cs,
+                          g->field,
+                          x,
+                          y,
+                          q->previews[1],
+                          drawpiece_instance_flags(drawpiece_flags | DRAWPIECE_PREVIEW | DRAWPIECE_SMALL, q->preview_flags[1]),
+                          FLAT,
+                          preview2_x,
+                          preview2_y,
+                          RGBA_DEFAULT);
         if(q->num_previews > 2)
-            gfx_drawpiece(
-                cs, g->field, x, y, q->previews[2], drawpiece_flags | DRAWPIECE_PREVIEW | DRAWPIECE_SMALL, FLAT, preview3_x, preview3_y, RGBA_DEFAULT);
+            gfx_drawpiece(cs,
+                          g->field,
+                          x,
+                          y,
+                          q->previews[2],
+                          drawpiece_instance_flags(drawpiece_flags | DRAWPIECE_PREVIEW | DRAWPIECE_SMALL, q->preview_flags[2]),
+                          FLAT,
+                          preview3_x,
+                          preview3_y,
+                          RGBA_DEFAULT);
 
         if(q->hold)
             gfx_drawpiece(cs,
@@ -596,7 +628,8 @@ int gfx_drawqs(game_t *g)
                           x,
                           y,
                           q->hold,
-                          drawpiece_flags | DRAWPIECE_PREVIEW | DRAWPIECE_SMALL | (q->p1->state & PSUSEDHOLD ? DRAWPIECE_LOCKFLASH : 0),
+                          drawpiece_instance_flags(drawpiece_flags | DRAWPIECE_PREVIEW | DRAWPIECE_SMALL | (q->p1->state & PSUSEDHOLD ? DRAWPIECE_LOCKFLASH : 0),
+                                                   q->hold_flags),
                           FLAT,
                           hold_x,
                           hold_y,
@@ -604,12 +637,9 @@ int gfx_drawqs(game_t *g)
 
         if((q->p1->state & (PSFALL | PSLOCK)) && !(q->p1->state & PSPRELOCKED))
         {
-            if(!(pd_current->flags & PDBRACKETS))
+            if(!(q->p1->def_flags & PDBRACKETS))
             {
-                y_bkp = q->p1->y;
-                s_bkp = q->p1->state;
-                qrs_fall(g, q->p1, 28 * 256);
-                piece_y = y + (16 * YTOROW(q->p1->y)) - 16;
+                piece_y = y + (16 * (YTOROW(q->p1->y) + qrs_drop_distance(g, q->p1))) - 16;
 
                 switch(q->mode_type)
                 {
@@ -626,24 +656,22 @@ int gfx_drawqs(game_t *g)
                         break;
                 }
 
-                q->p1->y = y_bkp;
-                q->p1->state = s_bkp;
                 piece_y = y + (16 * YTOROW(q->p1->y)) - 16;
             }
 
-            if(pd_current->flags & PDBRACKETS)
+            if(q->p1->def_flags & PDBRACKETS)
                 rgba = RGBA_DEFAULT;
 
-            gfx_drawpiece(cs, g->field, x, y, pd_current, drawpiece_flags, q->p1->orient, piece_x, piece_y, rgba);
+            gfx_drawpiece(cs, g->field, x, y, pd_current, drawpiece_instance_flags(drawpiece_flags, q->p1->def_flags), q->p1->orient, piece_x, piece_y, rgba);
         }
         else if(q->p1->state & (PSLOCKFLASH1 | PSLOCKFLASH2) && !(q->state_flags & GAMESTATE_BRACKETS))
-            gfx_drawpiece(cs, g->field, x, y, pd_current, drawpiece_flags | DRAWPIECE_LOCKFLASH, q->p1->orient, piece_x, piece_y, RGBA_DEFAULT);
+            gfx_drawpiece(cs, g->field, x, y, pd_current, drawpiece_instance_flags(drawpiece_flags | DRAWPIECE_LOCKFLASH, q->p1->def_flags), q->p1->orient, piece_x, piece_y, RGBA_DEFAULT);
         else if(q->p1->state & PSPRELOCKED)
         {
             if(q->state_flags & GAMESTATE_BRACKETS)
-                gfx_drawpiece(cs, g->field, x, y, pd_current, drawpiece_flags, q->p1->orient, piece_x, piece_y, RGBA_DEFAULT);
+                gfx_drawpiece(cs, g->field, x, y, pd_current, drawpiece_instance_flags(drawpiece_flags, q->p1->def_flags), q->p1->orient, piece_x, piece_y, RGBA_DEFAULT);
             else
-                gfx_drawpiece(cs, g->field, x, y, pd_current, drawpiece_flags, q->p1->orient, piece_x, piece_y, 0x404040FF);
+                gfx_drawpiece(cs, g->field, x, y, pd_current, drawpiece_instance_flags(drawpiece_flags, q->p1->def_flags), q->p1->orient, piece_x, piece_y, 0x404040FF);
         }
     }
 
@@ -933,7 +961,7 @@ int gfx_drawfield_selection(game_t *g, struct pracdata *d)
         {
             if(i >= 0 && i < 12 && j >= 0 && j < 20)
             {
-                if(gridgetcell(d->usr_field, i, j + 2) != QRS_FIELD_W_LIMITER)
+                if(gridgetcell(d->field->usr_field, i, j + 2) != QRS_FIELD_W_LIMITER)
                 {
                     dest.x = q->field_x + 16 * (i + 1);
                     dest.y = QRS_FIELD_Y + 16 * (j + 2);
@@ -17,6 +17,9 @@ typedef struct
 } gfx_image;
 
 bool img_load(gfx_image *img, const char *path_without_ext, coreState *cs);
+SDL_Surface *img_load_surface(const char *path_without_ext);
+SDL_Surface *img_load_surface_rw(SDL_RWops *rw);
+bool img_load_from_surface(gfx_image *img, SDL_Surface *s, coreState *cs);
 void img_destroy(gfx_image *img);
 
 enum text_alignment { ALIGN_LEFT, ALIGN_RIGHT, ALIGN_CENTER };
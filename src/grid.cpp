@@ -3,6 +3,16 @@
 
 #include "grid.h"
 
+// physical index of row y; avoids a modulo, which the Vita's CPU has no instruction for
+static inline int grid_row(grid_t *g, int y)
+{
+    y += g->row_offset;
+    if(y >= g->h)
+        y -= g->h;
+
+    return y;
+}
+
 grid_t *grid_create(int w, int h) // allocate first horizontally, then vertically
 {
     if(w < 1 || h < 1)
@@ -14,6 +24,8 @@ grid_t *grid_create(int w, int h) // allocate first horizontally, then verticall
     grid_t *g = (grid_t *)malloc(sizeof(grid_t));
     g->w = w;
     g->h = h;
+    g->row_offset = 0;
+    g->scratch = (int *)malloc(h * sizeof(int));
     g->grid = (int **)malloc(w * sizeof(int *));
 
     for(i = 0; i < w; i++)
@@ -39,6 +51,7 @@ void grid_destroy(grid_t *g)
         free(g->grid[i]);
 
     free(g->grid);
+    free(g->scratch);
     free(g);
 }
 
@@ -87,7 +100,7 @@ int gridsetcell(grid_t *g, int x, int y, int val)
     if(val == GRID_OOB)
         return 1;
 
-    g->grid[x][y] = val;
+    g->grid[x][grid_row(g, y)] = val;
 
     return 0;
 }
@@ -116,7 +129,7 @@ int gridgetcell(grid_t *g, int x, int y)
     if(x < 0 || y < 0 || x >= g->w || y >= g->h)
         return GRID_OOB;
 
-    return g->grid[x][y];
+    return g->grid[x][grid_row(g, y)];
 }
 
 grid_t *gridcpy(grid_t *src, grid_t *dest)
@@ -143,7 +156,7 @@ grid_t *gridcpy(grid_t *src, grid_t *dest)
     for(i = 0; i < w; i++)
     {
         for(j = 0; j < h; j++)
-            cpy->grid[i][j] = src->grid[i][j];
+            cpy->grid[i][grid_row(cpy, j)] = src->grid[i][grid_row(src, j)];
     }
 
     return cpy;
@@ -174,6 +187,127 @@ int gridrowcpy(grid_t *src, grid_t *dest, int srcrow, int destrow)
     return 0;
 }
 
+int grid_remove_rows(grid_t *g, int *rows, int num_rows, int first_col, int last_col)
+{
+    if(!g || !rows)
+        return -1;
+    if(num_rows < 1)
+        return 0;
+    if(first_col < 0 || last_col > g->w || rows[0] < 0 || rows[num_rows - 1] >= g->h)
+        return 1;
+
+    int i = 0;
+    int j = 0;
+    int k = 0;
+    int dest = 0;
+    int top = rows[0];
+    int bottom = rows[num_rows - 1];
+    int new_offset = g->row_offset - num_rows;
+    int *col = NULL;
+    int *tmp = g->scratch;
+
+    if(new_offset < 0)
+        new_offset += g->h;
+
+    /* two ways to do this:
+       - move every row above the lowest removed row down (rows 0..bottom written in each column)
+       - rotate the ring down by num_rows, which puts everything above the highest removed row in place for free,
+         then fix up the rows from there to the bottom (top..h-1 written in each column, plus every row of the
+         columns outside first_col..last_col-1, which the rotation moved as well)
+       clears usually happen near the bottom of a tall stack, where the second way is much cheaper */
+    if((last_col - first_col) * (bottom + 1) <= (last_col - first_col) * (g->h - top) + (g->w - (last_col - first_col)) * g->h)
+    {
+        for(i = first_col; i < last_col; i++)
+        {
+            col = g->grid[i];
+            k = num_rows - 1;
+            dest = bottom;
+
+            // everything below the lowest removed row stays where it is
+            for(j = bottom; j >= 0; j--)
+            {
+                if(k >= 0 && rows[k] == j)
+                {
+                    k--;
+                    continue;
+                }
+
+                col[grid_row(g, dest)] = col[grid_row(g, j)];
+                dest--;
+            }
+
+            for(; dest >= 0; dest--)
+                col[grid_row(g, dest)] = 0;
+        }
+
+        return 0;
+    }
+
+    for(i = 0; i < g->w; i++)
+    {
+        col = g->grid[i];
+
+        // gather the final contents of rows top + num_rows..h-1 before the rotation scrambles them
+        if(i >= first_col && i < last_col)
+        {
+            k = num_rows - 1;
+            dest = g->h - 1;
+
+            for(j = g->h - 1; dest >= top + num_rows; j--)
+            {
+                if(k >= 0 && rows[k] == j)
+                {
+                    k--;
+                    continue;
+                }
+
+                tmp[dest] = col[grid_row(g, j)];
+                dest--;
+            }
+
+            for(j = 0; j < num_rows; j++)
+                tmp[j] = 0;
+        }
+        else
+        {
+            for(j = 0; j < g->h; j++)
+                tmp[j] = col[grid_row(g, j)];
+        }
+
+        for(j = 0; j < g->h; j++)
+        {
+            if(i >= first_col && i < last_col && j >= num_rows && j < top + num_rows)
+                continue;
+
+            dest = j + new_offset;
+            if(dest >= g->h)
+                dest -= g->h;
+
+            col[dest] = tmp[j];
+        }
+    }
+
+    g->row_offset = new_offset;
+
+    return 0;
+}
+
+int grid_rotate_rows(grid_t *g, int n)
+{
+    if(!g)
+        return -1;
+
+    n %= g->h;
+    if(n < 0)
+        n += g->h;
+
+    g->row_offset += n;
+    if(g->row_offset >= g->h)
+        g->row_offset -= g->h;
+
+    return 0;
+}
+
 int gridxytopos(grid_t *g, int x, int y) { return ((y * g->w) + x); }
 
 int gridpostox(grid_t *g, int pos) { return (pos % g->w); }
@@ -212,12 +346,13 @@ grid_t *grid_yx_to_xy(grid_t *g)
 
     h->w = g->h;
     h->h = g->w;
+    h->row_offset = 0;
 
     for(i = 0; i < g->w; i++)
     {
         for(j = 0; j < g->h; j++)
         {
-            h->grid[j][i] = g->grid[i][j];
+            h->grid[j][i] = g->grid[i][grid_row(g, j)];
         }
     }
 
@@ -10,6 +10,12 @@ typedef struct
     int w;
     int h;
     int **grid; // grid[w][h] / grid[column #][row #]
+
+    // rows are stored as a ring: row y lives at grid[x][(y + row_offset) % h]
+    // lets whole rows be shifted (rising garbage, line clears) by changing this instead of copying cells
+    int row_offset;
+
+    int *scratch;    // h cells, for grid_remove_rows() to build a column in
 } grid_t;
 
 typedef grid_t yx_grid_t;
@@ -25,6 +31,10 @@ int gridgetcell(grid_t *g, int x, int y);
 
 grid_t *gridcpy(grid_t *src, grid_t *dest);
 int gridrowcpy(grid_t *src, grid_t *dest, int srcrow, int destrow);
+// rows must be in ascending order; the cells above each removed row in columns first_col..last_col-1 drop down to fill it
+int grid_remove_rows(grid_t *g, int *rows, int num_rows, int first_col, int last_col);
+// shifts every row up by n (down if n is negative); rows pushed off one end reappear at the other
+int grid_rotate_rows(grid_t *g, int n);
 
 int gridgetsize(grid_t *g);
 int gridxytopos(grid_t *g, int x, int y);
@@ -18,12 +18,54 @@
 
 using namespace std;
 
+#define USER_DATA_DIR "ux0:data/shiromino"    // app0: is read-only, so anything the game saves goes here
+
 bool file_exists(const char *filename)
 {
     struct stat buffer = {0};
     return stat(filename, &buffer) == 0;
 }
 
+static int copy_file(const char *from, const char *to)
+{
+    FILE *in = fopen(from, "rb");
+    FILE *out = NULL;
+    char buf[0x1000];
+    size_t len = 0;
+    int rc = 0;
+
+    if(!in)
+        return 1;
+
+    out = fopen(to, "wb");
+    if(!out)
+    {
+        fclose(in);
+        return 1;
+    }
+
+    while((len = fread(buf, 1, sizeof(buf), in)) > 0)
+    {
+        if(fwrite(buf, 1, len, out) != len)
+        {
+            rc = 1;
+            break;
+        }
+    }
+
+    if(ferror(in))
+        rc = 1;
+
+    fclose(in);
+    if(fclose(out))
+        rc = 1;
+
+    if(rc)
+        remove(to);
+
+    return rc;
+}
+
 int main(int argc, char *argv[])
 {
     debug_init();
@@ -38,6 +80,7 @@ int main(int argc, char *argv[])
     string cfg = "game.cfg";
     string slash = "/";
     string cfg_filename;
+    string user_cfg_filename = USER_DATA_DIR "/game.cfg";
 
     game_t *distr_test = NULL;
 
@@ -63,21 +106,37 @@ int main(int argc, char *argv[])
         goto error;
     }
 
+    // the copy in ux0: is the one read, watched and saved to; app0:'s only seeds it on the first run
+    if(!file_exists(user_cfg_filename.c_str()))
+    {
+        mkdir(USER_DATA_DIR, 0777);
+
+        if(copy_file(cfg_filename.c_str(), user_cfg_filename.c_str()))
+            log_err("Couldn't copy %s to %s, settings won't be saved\n", cfg_filename.c_str(), user_cfg_filename.c_str());
+        else
+            log_info("Copied %s to %s\n", cfg_filename.c_str(), user_cfg_filename.c_str());
+    }
+
+    if(file_exists(user_cfg_filename.c_str()))
+    {
+        cfg_filename = user_cfg_filename;
+        cs.cfg_filename = (char *)(cfg_filename.c_str());
+    }
+
     s = parse_cfg(cfg_filename.c_str());
     if(!s)
     {
         log_info("Using default settings\n");
     }
 
-    cs.cfg_filename = (char *)(cfg_filename.c_str());
-
-    log_info("Finished reading configuration file: %s\n", cs.cfg_filename);
+    log_info("Finished reading configuration file: %s\n", cfg_filename.c_str());
 
     if(init(&cs, s))
     {
         log_err("Initialization failed, aborting.\n");
         quit(&cs);
         coreState_destroy(&cs);
+        debug_quit();
         return 1;
     }
 
@@ -86,9 +145,11 @@ int main(int argc, char *argv[])
     quit(&cs);
     coreState_destroy(&cs);
 
+    debug_quit();
     return 0;
 
 error:
     coreState_destroy(&cs);
+    debug_quit();
     return 1;
 }
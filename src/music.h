@@ -1,21 +1,21 @@
-// internal name, relative filename
+// internal name, relative filename, group (see asset_cache.h)
 
-MUS(track0, "track0")
-MUS(track1, "track1")
-MUS(track2, "track2")
-MUS(track3, "track3")
+MUS(track0, "track0", ASSET_GROUP_PENTOMINO)
+MUS(track1, "track1", ASSET_GROUP_PENTOMINO)
+MUS(track2, "track2", ASSET_GROUP_PENTOMINO)
+MUS(track3, "track3", ASSET_GROUP_PENTOMINO)
 
-MUS(g1_track0, "g1/track0")
-MUS(g1_track1, "g1/track1")
+MUS(g1_track0, "g1/track0", ASSET_GROUP_G1)
+MUS(g1_track1, "g1/track1", ASSET_GROUP_G1)
 
-MUS(g2_track0, "g2/track0")
-MUS(g2_track1, "g2/track1")
-MUS(g2_track2, "g2/track2")
-MUS(g2_track3, "g2/track3")
+MUS(g2_track0, "g2/track0", ASSET_GROUP_G2)
+MUS(g2_track1, "g2/track1", ASSET_GROUP_G2)
+MUS(g2_track2, "g2/track2", ASSET_GROUP_G2)
+MUS(g2_track3, "g2/track3", ASSET_GROUP_G2)
 
-MUS(g3_track0, "g3/track0")
-MUS(g3_track1, "g3/track1")
-MUS(g3_track2, "g3/track2")
-MUS(g3_track3, "g3/track3")
-MUS(g3_track4, "g3/track4")
-MUS(g3_track5, "g3/track5")
+MUS(g3_track0, "g3/track0", ASSET_GROUP_G3)
+MUS(g3_track1, "g3/track1", ASSET_GROUP_G3)
+MUS(g3_track2, "g3/track2", ASSET_GROUP_G3)
+MUS(g3_track3, "g3/track3", ASSET_GROUP_G3)
+MUS(g3_track4, "g3/track4", ASSET_GROUP_G3)
+MUS(g3_track5, "g3/track5", ASSET_GROUP_G3)
@@ -1,6 +1,7 @@
 #include <SDL2/SDL.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "grid.h"
 #include "piecedef.h"
@@ -18,6 +19,8 @@ piecedef *piecedef_create()
     for(i = 0; i < 4; i++)
         pd->rotation_tables[i] = grid_create(4, 4);
 
+    pd_update_profiles(pd);
+
     return pd;
 }
 
@@ -49,6 +52,8 @@ piecedef *piecedef_cpy(piecedef *pd)
     for(i = 0; i < 4; i++)
         pd_new->rotation_tables[i] = gridcpy(pd->rotation_tables[i], NULL);
 
+    memcpy(pd_new->bottom_profiles, pd->bottom_profiles, sizeof(pd->bottom_profiles));
+
     return pd_new;
 }
 
@@ -106,6 +111,42 @@ int pdsetcell(piecedef *pd, int orientation, int x, int y)
     if(gridsetcell(g, x, y, (val ^ 1)))
         return 1;
 
+    pd_update_profiles(pd);
+
+    return 0;
+}
+
+int pd_update_profiles(piecedef *pd)
+{
+    if(!pd)
+        return -1;
+
+    int i = 0;
+    int x = 0;
+    int y = 0;
+    grid_t *g = NULL;
+
+    for(i = 0; i < 4; i++)
+    {
+        g = pd->rotation_tables[i];
+
+        for(x = 0; x < PD_PROFILE_W; x++)
+        {
+            pd->bottom_profiles[i][x] = -1;
+            if(x >= g->w)
+                continue;
+
+            for(y = g->h - 1; y >= 0; y--)
+            {
+                if(gridgetcell(g, x, y))
+                {
+                    pd->bottom_profiles[i][x] = y;
+                    break;
+                }
+            }
+        }
+    }
+
     return 0;
 }
 /*
@@ -13,6 +13,8 @@
 #define PDPREFERWKICK 0x00000020
 #define PDAIRBORNEFKICKS 0x00000040
 
+#define PD_PROFILE_W 5
+
 enum { FLAT = 0, CW = 1, FLIP = 2, CCW = 3 };
 
 typedef struct
@@ -22,6 +24,10 @@ typedef struct
     int anchorx;
     int anchory;
     grid_t *rotation_tables[4]; // these grids technically don't have to be the same size
+
+    // lowest filled row of each column of each rotation table, -1 for empty columns
+    // only valid for rotation tables up to PD_PROFILE_W wide
+    int bottom_profiles[4][PD_PROFILE_W];
 } piecedef;
 
 piecedef *piecedef_create();
@@ -32,5 +38,6 @@ piecedef *piecedef_cpy(piecedef *pd);
 int pdsetw(piecedef *pd, int w);
 int pdseth(piecedef *pd, int h);
 int pdsetcell(piecedef *pd, int orientation, int x, int y);
+int pd_update_profiles(piecedef *pd);
 // int pdchkflags(piecedef *pd, unsigned int tflags);
 #endif
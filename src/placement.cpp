@@ -0,0 +1,299 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "core.h"
+#include "placement.h"
+#include "qrs.h"
+#include "rotation_tables.h"
+
+struct placement_search *placement_search_create()
+{
+    struct placement_search *s = (struct placement_search *)malloc(sizeof(struct placement_search));
+
+    s->visited = (uint8_t *)malloc(PLACEMENT_NUM_STATES);
+    s->nodes = (struct placement_node *)malloc(PLACEMENT_NUM_STATES * sizeof(struct placement_node));
+    s->num_nodes = 0;
+    s->num_placements = 0;
+
+    return s;
+}
+
+void placement_search_destroy(struct placement_search *s)
+{
+    if(!s)
+        return;
+
+    free(s->visited);
+    free(s->nodes);
+    free(s);
+}
+
+static int placement_state_index(qrs_player *p, int floorkicks, int lock_on_rotate)
+{
+    int x = p->x - PLACEMENT_X_MIN;
+    int y = YTOROW(p->y) - PLACEMENT_Y_MIN;
+
+    if(x < 0 || x >= PLACEMENT_X_RANGE || y < 0 || y >= PLACEMENT_Y_RANGE)
+        return -1;
+
+    return (((y * PLACEMENT_X_RANGE + x) * 4 + p->orient) * (PLACEMENT_MAX_FLOORKICKS + 1) + floorkicks) * 3 + lock_on_rotate;
+}
+
+static void placement_push(struct placement_search *s, qrs_player *p, int floorkicks, int lock_on_rotate, int parent, int input)
+{
+    struct placement_node *n = NULL;
+    int depth = parent < 0 ? 0 : s->nodes[parent].depth;
+    int i = placement_state_index(p, floorkicks, lock_on_rotate);
+
+    if(i < 0 || s->visited[i])
+        return;
+
+    if(input != PLACEMENT_NONE)
+        depth++;
+
+    if(depth > PLACEMENT_MAX_INPUTS)
+        return;
+
+    s->visited[i] = 1;
+
+    n = &s->nodes[s->num_nodes++];
+    n->x = p->x;
+    n->y = YTOROW(p->y);
+    n->orient = p->orient;
+    n->floorkicks = floorkicks;
+    n->lock_on_rotate = lock_on_rotate;
+    n->input = input;
+    n->depth = depth;
+    n->parent = parent;
+}
+
+static void placement_add(struct placement_search *s, qrs_player *p, int node)
+{
+    const struct qrs_shape *sh = &qrs_shapes.pieces[p->def->qrs_id];
+    const struct qrs_shape_rot *r = &sh->rot[p->orient];
+    struct placement *pl = NULL;
+    int cells[PLACEMENT_MAX_CELLS];
+    int num_cells = 0;
+    int x = p->x - p->def->anchorx;
+    int y = YTOROW(p->y) - p->def->anchory;
+    int i = 0;
+    int j = 0;
+
+    if(s->num_placements == PLACEMENT_MAX)
+        return;
+
+    for(i = r->min_y; i <= r->max_y; i++)
+    {
+        for(j = r->left[i]; j <= r->right[i]; j++)
+        {
+            if(r->mask & (1u << (i * sh->w + j)))
+                cells[num_cells++] = (y + i) * QRS_FIELD_W + x + j;
+        }
+    }
+
+    // BFS order means an earlier placement with the same cells had a path at least as short
+    for(i = 0; i < s->num_placements; i++)
+    {
+        if(s->placements[i].num_cells == num_cells && !memcmp(s->placements[i].cells, cells, num_cells * sizeof(int)))
+            return;
+    }
+
+    pl = &s->placements[s->num_placements++];
+    pl->x = p->x;
+    pl->y = YTOROW(p->y);
+    pl->orient = p->orient;
+    pl->num_cells = num_cells;
+    memcpy(pl->cells, cells, num_cells * sizeof(int));
+
+    pl->num_inputs = s->nodes[node].depth;
+    j = pl->num_inputs;
+
+    for(i = node; i >= 0; i = s->nodes[i].parent)
+    {
+        if(s->nodes[i].input != PLACEMENT_NONE)
+            pl->inputs[--j] = s->nodes[i].input;
+    }
+}
+
+// rows_per_frame >= 20 is 20G, 0 lets the piece hang in place (sub-1G gravity, the player can outwait it)
+static void placement_fall(game_t *g, qrs_player *p, int rows_per_frame)
+{
+    int dist = 0;
+
+    if(rows_per_frame <= 0)
+        return;
+
+    dist = qrs_drop_distance(g, p);
+    if(dist > rows_per_frame)
+        dist = rows_per_frame;
+
+    p->y += ROWTOY(dist);
+}
+
+static void placement_expand(game_t *g, struct placement_search *s, const piecedef *def, int grav)
+{
+    qrsdata *q = (qrsdata *)g->data;
+    qrs_player p;
+    struct placement_node n;
+    const int inputs[5] = {PLACEMENT_LEFT, PLACEMENT_RIGHT, PLACEMENT_CW, PLACEMENT_CCW, PLACEMENT_DOWN};
+
+    unsigned int bkp_floorkicks = q->p1counters->floorkicks;
+    int rows_per_frame = grav / 256;
+    int max_floorkicks = q->max_floorkicks;
+    bool limited_floorkicks = max_floorkicks != 0;
+    int floorkicks = 0;
+    int lock_on_rotate = 0;
+    int i = 0;
+    int j = 0;
+
+    if(q->pracdata && q->pracdata->infinite_floorkicks)
+        limited_floorkicks = false;
+    if(max_floorkicks > PLACEMENT_MAX_FLOORKICKS)
+        max_floorkicks = PLACEMENT_MAX_FLOORKICKS;
+
+    p.def = def;
+    p.def_flags = 0;
+    p.speeds = NULL;
+
+    for(i = 0; i < s->num_nodes; i++)
+    {
+        n = s->nodes[i];
+
+        p.x = n.x;
+        p.y = ROWTOY(n.y);
+        p.orient = n.orient;
+
+        if(qrs_isonground(g, &p))
+        {
+            placement_add(s, &p, i);
+
+            // the second rotation after the floorkick limit locks the piece as soon as it's on the ground
+            if(n.lock_on_rotate == 2)
+                continue;
+        }
+
+        for(j = 0; j < 5; j++)
+        {
+            p.x = n.x;
+            p.y = ROWTOY(n.y);
+            p.orient = n.orient;
+            p.state = PSFALL;
+            floorkicks = n.floorkicks;
+            lock_on_rotate = n.lock_on_rotate;
+
+            switch(inputs[j])
+            {
+                case PLACEMENT_LEFT:
+                    if(qrs_move(g, &p, MOVE_LEFT))
+                        continue;
+                    break;
+
+                case PLACEMENT_RIGHT:
+                    if(qrs_move(g, &p, MOVE_RIGHT))
+                        continue;
+                    break;
+
+                case PLACEMENT_CW:
+                case PLACEMENT_CCW:
+                    q->p1counters->floorkicks = floorkicks;
+                    if(qrs_rotate(g, &p, inputs[j] == PLACEMENT_CW ? CW : CCW))
+                        continue;
+
+                    floorkicks = q->p1counters->floorkicks;
+                    if(floorkicks > max_floorkicks)
+                        floorkicks = max_floorkicks;
+
+                    if(limited_floorkicks && floorkicks >= max_floorkicks)
+                        lock_on_rotate = lock_on_rotate == 1 ? 2 : 1;
+                    break;
+
+                case PLACEMENT_DOWN:
+                    if(rows_per_frame >= 20 || qrs_isonground(g, &p))
+                        continue;
+
+                    p.y += 256;
+                    break;
+
+                default:
+                    break;
+            }
+
+            placement_fall(g, &p, rows_per_frame);
+            placement_push(s, &p, floorkicks, lock_on_rotate, i, inputs[j]);
+        }
+    }
+
+    q->p1counters->floorkicks = bkp_floorkicks;
+}
+
+static void placement_reset(struct placement_search *s)
+{
+    memset(s->visited, 0, PLACEMENT_NUM_STATES);
+    s->num_nodes = 0;
+    s->num_placements = 0;
+}
+
+int placement_enumerate(game_t *g, struct placement_search *s, piece_id id, int grav)
+{
+    if(!g || !s || id >= 25)
+        return -1;
+
+    qrsdata *q = (qrsdata *)g->data;
+    qrs_player p;
+    const int irs_inputs[4] = {PLACEMENT_NONE, PLACEMENT_IRS_CW, PLACEMENT_IRS_FLIP, PLACEMENT_IRS_CCW};
+    int i = 0;
+
+    placement_reset(s);
+
+    p.def = qrspiece_get(q->piecepool, id);
+    p.def_flags = 0;
+    p.speeds = NULL;
+    p.state = PSFALL;
+
+    // IRS: any orientation that fits at the spawn position (FLIP only with special IRS, like qrs_irs())
+    for(i = 0; i < 4; i++)
+    {
+        if(i == FLIP && !(q->special_irs && !q->hold_enabled))
+            continue;
+
+        p.x = SPAWNX_QRS;
+        p.y = ROWTOY(id >= 18 ? SPAWNY_QRS + 2 : SPAWNY_QRS);
+        p.orient = i;
+
+        if(qrs_chkcollision(g, &p))
+            continue;
+
+        placement_fall(g, &p, grav / 256);
+        placement_push(s, &p, 0, 0, -1, irs_inputs[i]);
+    }
+
+    placement_expand(g, s, p.def, grav);
+
+    return 0;
+}
+
+int placement_enumerate_from(game_t *g, struct placement_search *s, qrs_player *p, int grav)
+{
+    if(!g || !s || !p || !p->def)
+        return -1;
+
+    qrsdata *q = (qrsdata *)g->data;
+    qrs_player start = *p;
+    int floorkicks = q->p1counters->floorkicks;
+
+    placement_reset(s);
+
+    if(floorkicks > (int)q->max_floorkicks)
+        floorkicks = q->max_floorkicks;
+    if(floorkicks > PLACEMENT_MAX_FLOORKICKS)
+        floorkicks = PLACEMENT_MAX_FLOORKICKS;
+
+    // the search works in whole rows; the game itself only ever collides at YTOROW(y)
+    start.y = ROWTOY(YTOROW(start.y));
+
+    placement_push(s, &start, floorkicks, q->lock_on_rotate, -1, PLACEMENT_NONE);
+    placement_expand(g, s, p->def, grav);
+
+    return 0;
+}
@@ -0,0 +1,88 @@
+#ifndef _placement_h
+#define _placement_h
+
+#include <stdint.h>
+#include "core.h"
+#include "qrs.h"
+
+#define PLACEMENT_MAX_INPUTS 32
+#define PLACEMENT_MAX_CELLS 5
+#define PLACEMENT_MAX 256
+
+// floorkick counts are only tracked up to this; q->max_floorkicks above it is treated as this
+#define PLACEMENT_MAX_FLOORKICKS 4
+
+// piece positions the search can represent, well past the walls on every side
+#define PLACEMENT_X_MIN -4
+#define PLACEMENT_X_RANGE (QRS_FIELD_W + 8)
+#define PLACEMENT_Y_MIN -4
+#define PLACEMENT_Y_RANGE (QRS_FIELD_H + 8)
+
+#define PLACEMENT_NUM_STATES (PLACEMENT_X_RANGE * PLACEMENT_Y_RANGE * 4 * (PLACEMENT_MAX_FLOORKICKS + 1) * 3)
+
+enum placement_input
+{
+    PLACEMENT_NONE = 0,
+    PLACEMENT_IRS_CW,
+    PLACEMENT_IRS_CCW,
+    PLACEMENT_IRS_FLIP,
+    PLACEMENT_LEFT,
+    PLACEMENT_RIGHT,
+    PLACEMENT_CW,
+    PLACEMENT_CCW,
+    PLACEMENT_DOWN
+};
+
+struct placement
+{
+    int x;
+    int y; // in rows, not 1/256ths
+    int orient;
+
+    // field cells the piece covers once locked, as y * QRS_FIELD_W + x, in row-major order;
+    // two placements with the same cells leave the same field behind
+    int cells[PLACEMENT_MAX_CELLS];
+    int num_cells;
+
+    // shortest input path from spawn, one input per frame; the piece is locked by holding down afterwards
+    uint8_t inputs[PLACEMENT_MAX_INPUTS];
+    int num_inputs;
+};
+
+struct placement_node
+{
+    int8_t x;
+    int8_t y;
+    uint8_t orient;
+    uint8_t floorkicks;
+    uint8_t lock_on_rotate; // mirrors qrsdata::lock_on_rotate
+    uint8_t input;
+    uint8_t depth;
+
+    int parent;
+};
+
+/* breadth-first search over (x, y, orient) of every placement a piece can reach on the current field,
+   using the game's own collision and kick code (qrs_rotate/qrs_wallkick/qrs_floorkick, IRS, floorkick limits)
+
+   create once and reuse; placement_enumerate() doesn't allocate */
+struct placement_search
+{
+    uint8_t *visited;
+    struct placement_node *nodes;
+    int num_nodes;
+
+    struct placement placements[PLACEMENT_MAX];
+    int num_placements;
+};
+
+struct placement_search *placement_search_create();
+void placement_search_destroy(struct placement_search *s);
+
+// grav in 1/256ths of a row per frame, like qrs_timings::grav; >= 20 * 256 is 20G
+int placement_enumerate(game_t *g, struct placement_search *s, piece_id id, int grav);
+
+// same, but from wherever p currently is (no IRS), continuing its floorkick count
+int placement_enumerate_from(game_t *g, struct placement_search *s, qrs_player *p, int grav);
+
+#endif
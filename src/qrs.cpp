@@ -1,6 +1,7 @@
 #include <SDL2/SDL.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <string.h>
 #include <time.h>
 
 #include "core.h"
@@ -38,15 +39,11 @@ void qrsdata_destroy(qrsdata *q)
     if(!q)
         return;
 
-    int i;
-
-    for(i = 0; i < 25; i++)
-        piecedef_destroy(q->piecepool[i]);
     nz_timer_destroy(q->timer);
-    // if(q->p1->def) piecedef_destroy(q->p1->def);
     free(q->p1);
     free(q->p1counters);
-    free(q->piecepool);
+    qrspool_destroy(q->piecepool);
+    grid_destroy(q->garbage);
 
     if(q->replay)
     {
@@ -56,168 +53,107 @@ void qrsdata_destroy(qrsdata *q)
     free(q);
 }
 
-void pracdata_destroy(struct pracdata *d)
+struct pracdata_seq *pracdata_seq_create()
 {
-    if(!d)
-        return;
-
-    int i = 0;
-
-    if(d->usr_field_undo)
-    {
-        for(i = 0; i < d->usr_field_undo_len; i++)
-        {
-            if(d->usr_field_undo[i])
-                grid_destroy(d->usr_field_undo[i]);
-        }
+    struct pracdata_seq *s = (struct pracdata_seq *)malloc(sizeof(struct pracdata_seq));
 
-        free(d->usr_field_undo);
-    }
+    s->usr_seq_len = 0;
+    s->usr_seq_ops = NULL;
+    s->usr_seq_num_ops = 0;
 
-    if(d->usr_field_redo)
-    {
-        for(i = 0; i < d->usr_field_redo_len; i++)
-        {
-            if(d->usr_field_redo[i])
-                grid_destroy(d->usr_field_redo[i]);
-        }
+    return s;
+}
 
-        free(d->usr_field_redo);
-    }
+struct pracdata_field *pracdata_field_create()
+{
+    struct pracdata_field *f = (struct pracdata_field *)malloc(sizeof(struct pracdata_field));
 
-    if(d->usr_field)
-        grid_destroy(d->usr_field);
+    f->usr_field = qrsfield_create();
+    f->usr_field_stroke = qrsfield_create();
+    f->history = field_history_create();
 
-    if(d->usr_timings)
-        free(d->usr_timings);
+    return f;
 }
 
-struct pracdata *pracdata_cpy(struct pracdata *d)
+void pracdata_destroy(struct pracdata *d)
 {
     if(!d)
-        return NULL;
-
-    struct pracdata *cpy = (struct pracdata *)malloc(sizeof(struct pracdata));
-    int i = 0;
-
-    for(i = 0; i < d->usr_seq_len; i++)
-    {
-        cpy->usr_sequence[i] = d->usr_sequence[i];
-    }
-
-    for(i = 0; i < d->usr_seq_expand_len; i++)
-    {
-        cpy->usr_seq_expand[i] = d->usr_seq_expand[i];
-    }
-
-    cpy->usr_seq_len = d->usr_seq_len;
-    cpy->usr_seq_expand_len = d->usr_seq_expand_len;
-
-    cpy->usr_field_undo = (grid_t **)malloc(d->usr_field_undo_len * sizeof(grid_t *));
-    cpy->usr_field_redo = (grid_t **)malloc(d->usr_field_redo_len * sizeof(grid_t *));
+        return;
 
-    for(i = 0; i < d->usr_field_undo_len; i++)
+    if(d->seq)
     {
-        cpy->usr_field_undo[i] = gridcpy(d->usr_field_undo[i], NULL);
+        free(d->seq->usr_seq_ops);
+        free(d->seq);
     }
 
-    for(i = 0; i < d->usr_field_redo_len; i++)
+    if(d->field)
     {
-        cpy->usr_field_redo[i] = gridcpy(d->usr_field_redo[i], NULL);
+        grid_destroy(d->field->usr_field);
+        grid_destroy(d->field->usr_field_stroke);
+        field_history_destroy(d->field->history);
+        free(d->field);
     }
 
-    cpy->usr_field_undo_len = d->usr_field_undo_len;
-    cpy->usr_field_redo_len = d->usr_field_redo_len;
-
-    cpy->field_edit_in_progress = 0;
-
-    cpy->usr_field = gridcpy(d->usr_field, NULL);
-
-    cpy->palette_selection = QRS_PIECE_GARBAGE;
-    cpy->field_selection = d->field_selection;
-    cpy->field_selection_vertex1_x = d->field_selection_vertex1_x;
-    cpy->field_selection_vertex1_y = d->field_selection_vertex1_y;
-    cpy->field_selection_vertex2_x = d->field_selection_vertex2_x;
-    cpy->field_selection_vertex2_y = d->field_selection_vertex2_y;
-
-    cpy->usr_timings = (qrs_timings *)malloc(sizeof(qrs_timings));
-    cpy->usr_timings->level = 0;
-    cpy->usr_timings->grav = d->usr_timings->grav;
-    cpy->usr_timings->lock = d->usr_timings->lock;
-    cpy->usr_timings->are = d->usr_timings->are;
-    cpy->usr_timings->lineare = d->usr_timings->lineare;
-    cpy->usr_timings->das = d->usr_timings->das;
-    cpy->usr_timings->lineclear = d->usr_timings->lineclear;
-
-    cpy->hist_index = 0;
-    cpy->paused = QRS_FIELD_EDIT;
-    cpy->grid_lines_shown = d->grid_lines_shown;
-    cpy->brackets = d->brackets;
-    cpy->invisible = d->invisible;
-    cpy->lock_protect = d->lock_protect;
-    cpy->infinite_floorkicks = d->infinite_floorkicks;
-    cpy->piece_subset = d->piece_subset;
-    cpy->randomizer_seed = d->randomizer_seed;
-
-    return cpy;
+    if(d->usr_timings)
+        free(d->usr_timings);
 }
 
-piecedef **qrspool_create()
+const piecedef **qrspool_create()
 {
     piecedef **pool = (piecedef **)malloc(25 * sizeof(piecedef *));
+    const struct qrs_shape *s = NULL;
     int i = 0;
     int j = 0;
-    int n = 5;
-
-    int *arr = NULL;
+    int k = 0;
 
     for(i = 0; i < 25; i++)
     {
-        if(i >= 18)
-            n = 4;
+        s = &qrs_shapes.pieces[i];
 
         pool[i] = (piecedef *)malloc(sizeof(piecedef));
         pool[i]->qrs_id = i;
-        pool[i]->flags = 0;
+        pool[i]->flags = s->flags;
         pool[i]->anchorx = ANCHORX_QRS;
         pool[i]->anchory = ANCHORY_QRS;
 
         for(j = 0; j < 4; j++)
         {
-            if(n == 5)
-                arr = (int *)(qrspent_yx_rotation_tables[i][j]);
-            else
-                arr = (int *)(qrstet_yx_rotation_tables[i - 18][j]);
+            pool[i]->rotation_tables[j] = grid_create(s->w, s->w);
+
+            for(k = 0; k < s->w * s->w; k++)
+            {
+                if(s->rot[j].mask & (1u << k))
+                    gridsetcell(pool[i]->rotation_tables[j], k % s->w, k / s->w, 1);
+            }
 
-            pool[i]->rotation_tables[j] = grid_from_1d_int_array(arr, n, n);
+            for(k = 0; k < PD_PROFILE_W; k++)
+                pool[i]->bottom_profiles[j][k] = k < s->w ? s->rot[j].bottom[k] : -1;
         }
+    }
 
-        if(i == QRS_I || i == QRS_N || i == QRS_G || i == QRS_J || i == QRS_L || i == QRS_T || i == QRS_Ya || i == QRS_Yb)
-            pool[i]->flags ^= PDNOFKICK;
-        if(i == QRS_T)
-            pool[i]->flags |= PDFLATFLOORKICKS;
+    // nothing changes an entry from here on; per-game rule tweaks live in qrsdata
+    return (const piecedef **)pool;
+}
 
-        if(i == QRS_I4)
-            pool[i]->flags ^= PDNOWKICK;
+void qrspool_destroy(const piecedef **pool)
+{
+    int i = 0;
 
-        if(i == QRS_I4 || i == QRS_T4)
-        {
-            if(i == QRS_T4)
-                pool[i]->flags |= PDFLATFLOORKICKS | PDONECELLFLOORKICKS | PDPREFERWKICK | PDAIRBORNEFKICKS;
-        }
-        else
-            pool[i]->flags ^= PDNOFKICK;
-    }
+    if(!pool)
+        return;
+
+    for(i = 0; i < 25; i++)
+        piecedef_destroy((piecedef *)pool[i]);
 
-    return pool;
+    free(pool);
 }
 
-piecedef *qrspiece_cpy(piecedef **piecepool, int index)
+const piecedef *qrspiece_get(const piecedef **piecepool, int index)
 {
     if(index < 0 || index > 24)
         return NULL;
 
-    return piecedef_cpy(piecepool[index]);
+    return piecepool[index];
 }
 
 grid_t *qrsfield_create()
@@ -267,7 +203,7 @@ int ufu_not_exists(coreState *cs)
     if(!q)
         return 1;
 
-    if((q->pracdata->usr_field_undo_len || q->pracdata->usr_field_redo_len) && q->pracdata->paused == QRS_FIELD_EDIT)
+    if((q->pracdata->field->history->num_undo || q->pracdata->field->history->num_redo) && q->pracdata->paused == QRS_FIELD_EDIT)
         return 0;
     else
         return 1;
@@ -275,40 +211,141 @@ int ufu_not_exists(coreState *cs)
     return 1;
 }
 
+struct field_history *field_history_create()
+{
+    struct field_history *h = (struct field_history *)malloc(sizeof(struct field_history));
+
+    h->first_edit = 0;
+    h->num_undo = 0;
+    h->num_redo = 0;
+    h->num_cells = 0;
+
+    return h;
+}
+
+void field_history_destroy(struct field_history *h)
+{
+    if(h)
+        free(h);
+}
+
+static struct field_edit *field_history_edit(struct field_history *h, int n)
+{
+    return &h->edits[(h->first_edit + n) % FIELD_HISTORY_MAX_EDITS];
+}
+
+static struct field_edit_cell *field_history_cell(struct field_history *h, struct field_edit *e, int n)
+{
+    return &h->cells[(e->first_cell + n) % FIELD_HISTORY_MAX_CELLS];
+}
+
+static void field_history_drop_oldest(struct field_history *h)
+{
+    h->num_cells -= field_history_edit(h, 0)->num_cells;
+    h->first_edit = (h->first_edit + 1) % FIELD_HISTORY_MAX_EDITS;
+    h->num_undo--;
+}
+
+// applies edit n of h to field, either forwards (new values) or backwards (old values)
+static void field_history_apply(struct field_history *h, int n, grid_t *field, bool undo)
+{
+    struct field_edit *e = field_history_edit(h, n);
+    struct field_edit_cell *c = NULL;
+    int i = 0;
+
+    for(i = 0; i < e->num_cells; i++)
+    {
+        c = field_history_cell(h, e, i);
+
+        // the field width may have changed since; walls stay where they are now
+        if(gridgetcell(field, c->x, c->y) == QRS_FIELD_W_LIMITER)
+            continue;
+
+        gridsetcell(field, c->x, c->y, undo ? c->old_val : c->new_val);
+    }
+}
+
+// call before an edit starts changing usr_field; usr_field_commit() records what it changed
 int usr_field_bkp(coreState *cs, struct pracdata *d)
 {
     if(!d)
         return 1;
 
-    int i = 0;
+    struct pracdata_field *f = d->field;
+
+    gridcpy(f->usr_field, f->usr_field_stroke);
+
+    return 0;
+}
 
-    if(!d->usr_field_undo)
+int usr_field_commit(coreState *cs, struct pracdata *d)
+{
+    if(!d)
+        return 1;
+
+    struct pracdata_field *f = d->field;
+    struct field_history *h = f->history;
+    struct field_edit *e = NULL;
+    struct field_edit_cell *c = NULL;
+    int num_cells = 0;
+    int old_val = 0;
+    int new_val = 0;
+    int x = 0;
+    int y = 0;
+
+    for(x = 0; x < f->usr_field->w; x++)
     {
-        d->usr_field_undo = (grid_t **)malloc(sizeof(grid_t *));
-        d->usr_field_undo[0] = gridcpy(d->usr_field, NULL);
-        d->usr_field_undo_len = 1;
+        for(y = 0; y < f->usr_field->h; y++)
+        {
+            if(gridgetcell(f->usr_field_stroke, x, y) != gridgetcell(f->usr_field, x, y))
+                num_cells++;
+        }
+    }
+
+    // strokes that didn't change anything don't clear the redo history
+    if(!num_cells)
+        return 0;
+
+    if(!h->num_undo && !h->num_redo)
         gfx_createbutton(
             cs, "CLEAR UNDO", QRS_FIELD_X + (16 * 16) - 6, QRS_FIELD_Y + 23 * 16 + 8 - 6, 0, push_undo_clear_confirm, ufu_not_exists, NULL, 0xC0C0FFFF);
-    }
-    else
+
+    while(h->num_redo)
     {
-        d->usr_field_undo_len++;
-        d->usr_field_undo = (grid_t **)realloc(d->usr_field_undo, d->usr_field_undo_len * sizeof(grid_t *));
-        d->usr_field_undo[d->usr_field_undo_len - 1] = gridcpy(d->usr_field, NULL);
+        h->num_cells -= field_history_edit(h, h->num_undo + h->num_redo - 1)->num_cells;
+        h->num_redo--;
     }
 
-    if(d->usr_field_redo)
+    while(h->num_undo && (h->num_undo == FIELD_HISTORY_MAX_EDITS || h->num_cells + num_cells > FIELD_HISTORY_MAX_CELLS))
+        field_history_drop_oldest(h);
+
+    e = field_history_edit(h, h->num_undo);
+    if(h->num_undo)
+        e->first_cell = (field_history_edit(h, h->num_undo - 1)->first_cell + field_history_edit(h, h->num_undo - 1)->num_cells) % FIELD_HISTORY_MAX_CELLS;
+    else
+        e->first_cell = 0;
+    e->num_cells = 0;
+
+    for(x = 0; x < f->usr_field->w; x++)
     {
-        for(i = 0; i < d->usr_field_redo_len; i++)
+        for(y = 0; y < f->usr_field->h; y++)
         {
-            grid_destroy(d->usr_field_redo[i]);
-        }
+            old_val = gridgetcell(f->usr_field_stroke, x, y);
+            new_val = gridgetcell(f->usr_field, x, y);
+            if(old_val == new_val)
+                continue;
 
-        free(d->usr_field_redo);
-        d->usr_field_redo = NULL;
-        d->usr_field_redo_len = 0;
+            c = field_history_cell(h, e, e->num_cells++);
+            c->x = x;
+            c->y = y;
+            c->old_val = old_val;
+            c->new_val = new_val;
+        }
     }
 
+    h->num_cells += num_cells;
+    h->num_undo++;
+
     return 0;
 }
 
@@ -317,34 +354,16 @@ int usr_field_undo(coreState *cs, struct pracdata *d)
     if(!d)
         return 1;
 
-    if(!d->usr_field_undo)
-        return 0;
+    struct pracdata_field *f = d->field;
+    struct field_history *h = f->history;
 
-    if(!d->usr_field_redo)
-    {
-        d->usr_field_redo = (grid_t **)malloc(sizeof(grid_t *));
-        d->usr_field_redo[0] = gridcpy(d->usr_field, NULL);
-        d->usr_field_redo_len = 1;
-    }
-    else
-    {
-        d->usr_field_redo_len++;
-        d->usr_field_redo = (grid_t **)realloc(d->usr_field_redo, d->usr_field_redo_len * sizeof(grid_t *));
-        d->usr_field_redo[d->usr_field_redo_len - 1] = gridcpy(d->usr_field, NULL);
-    }
+    if(!h->num_undo)
+        return 0;
 
-    d->usr_field_undo_len--;
-    d->usr_field = d->usr_field_undo[d->usr_field_undo_len];
+    field_history_apply(h, h->num_undo - 1, f->usr_field, true);
 
-    if(!d->usr_field_undo_len)
-    {
-        free(d->usr_field_undo);
-        d->usr_field_undo = NULL;
-    }
-    else
-    {
-        d->usr_field_undo = (grid_t **)realloc(d->usr_field_undo, d->usr_field_undo_len * sizeof(grid_t *));
-    }
+    h->num_undo--;
+    h->num_redo++;
 
     return 0;
 }
@@ -354,34 +373,16 @@ int usr_field_redo(coreState *cs, struct pracdata *d)
     if(!d)
         return 1;
 
-    if(!d->usr_field_redo)
-        return 0;
+    struct pracdata_field *f = d->field;
+    struct field_history *h = f->history;
 
-    if(!d->usr_field_undo)
-    {
-        d->usr_field_undo = (grid_t **)malloc(sizeof(grid_t *));
-        d->usr_field_undo[0] = gridcpy(d->usr_field, NULL);
-        d->usr_field_undo_len = 1;
-    }
-    else
-    {
-        d->usr_field_undo_len++;
-        d->usr_field_undo = (grid_t **)realloc(d->usr_field_undo, d->usr_field_undo_len * sizeof(grid_t *));
-        d->usr_field_undo[d->usr_field_undo_len - 1] = gridcpy(d->usr_field, NULL);
-    }
+    if(!h->num_redo)
+        return 0;
 
-    d->usr_field_redo_len--;
-    d->usr_field = d->usr_field_redo[d->usr_field_redo_len];
+    field_history_apply(h, h->num_undo, f->usr_field, false);
 
-    if(!d->usr_field_redo_len)
-    {
-        free(d->usr_field_redo);
-        d->usr_field_redo = NULL;
-    }
-    else
-    {
-        d->usr_field_redo = (grid_t **)realloc(d->usr_field_redo, d->usr_field_redo_len * sizeof(grid_t *));
-    }
+    h->num_undo++;
+    h->num_redo--;
 
     return 0;
 }
@@ -425,31 +426,12 @@ int undo_clear_confirm_no(coreState *cs, void *data)
 int usr_field_undo_clear(coreState *cs, void *data)
 {
     qrsdata *q = (qrsdata *)cs->p1game->data;
-    int i = 0;
-
-    if(q->pracdata->usr_field_undo)
-    {
-        for(i = 0; i < q->pracdata->usr_field_undo_len; i++)
-        {
-            grid_destroy(q->pracdata->usr_field_undo[i]);
-        }
+    struct field_history *h = q->pracdata->field->history;
 
-        free(q->pracdata->usr_field_undo);
-        q->pracdata->usr_field_undo = NULL;
-        q->pracdata->usr_field_undo_len = 0;
-    }
-
-    if(q->pracdata->usr_field_redo)
-    {
-        for(i = 0; i < q->pracdata->usr_field_redo_len; i++)
-        {
-            grid_destroy(q->pracdata->usr_field_redo[i]);
-        }
-
-        free(q->pracdata->usr_field_redo);
-        q->pracdata->usr_field_redo = NULL;
-        q->pracdata->usr_field_redo_len = 0;
-    }
+    h->first_edit = 0;
+    h->num_undo = 0;
+    h->num_redo = 0;
+    h->num_cells = 0;
 
     return 0;
 }
@@ -600,7 +582,7 @@ int qrs_input(game_t *g)
                     }
                     else if(cs->mouse_left_down && cell_x >= 0 && cell_x < 12 && cell_y >= 0 && cell_y < 20)
                     {
-                        if(gridgetcell(d->usr_field, cell_x, cell_y + 2) != QRS_FIELD_W_LIMITER)
+                        if(gridgetcell(d->field->usr_field, cell_x, cell_y + 2) != QRS_FIELD_W_LIMITER)
                         {
                             if(d->palette_selection != QRS_PIECE_GEM)
                             {
@@ -608,15 +590,15 @@ int qrs_input(game_t *g)
                                     usr_field_bkp(cs, d);
                                 d->field_edit_in_progress = 1;
                                 edit_action_occurred = 1;
-                                gridsetcell(d->usr_field, cell_x, cell_y + 2, d->palette_selection);
+                                gridsetcell(d->field->usr_field, cell_x, cell_y + 2, d->palette_selection);
                             }
-                            else if(gridgetcell(d->usr_field, cell_x, cell_y + 2) > 0)
+                            else if(gridgetcell(d->field->usr_field, cell_x, cell_y + 2) > 0)
                             {
                                 if(!d->field_edit_in_progress)
                                     usr_field_bkp(cs, d);
                                 d->field_edit_in_progress = 1;
                                 edit_action_occurred = 1;
-                                gridsetcell(d->usr_field, cell_x, cell_y + 2, gridgetcell(d->usr_field, cell_x, cell_y + 2) | QRS_PIECE_GEM);
+                                gridsetcell(d->field->usr_field, cell_x, cell_y + 2, gridgetcell(d->field->usr_field, cell_x, cell_y + 2) | QRS_PIECE_GEM);
                             }
                         }
                     }
@@ -633,13 +615,13 @@ int qrs_input(game_t *g)
                     }
                     else if(cs->mouse_right_down && cell_x >= 0 && cell_x < 12 && cell_y >= 0 && cell_y < 20)
                     {
-                        if(gridgetcell(d->usr_field, cell_x, cell_y + 2) != QRS_FIELD_W_LIMITER)
+                        if(gridgetcell(d->field->usr_field, cell_x, cell_y + 2) != QRS_FIELD_W_LIMITER)
                         {
                             if(!d->field_edit_in_progress)
                                 usr_field_bkp(cs, d);
                             d->field_edit_in_progress = 1;
                             edit_action_occurred = 1;
-                            gridsetcell(d->usr_field, cell_x, cell_y + 2, 0);
+                            gridsetcell(d->field->usr_field, cell_x, cell_y + 2, 0);
                         }
                     }
                 }
@@ -676,13 +658,13 @@ int qrs_input(game_t *g)
                             {
                                 if(i >= 0 && i < 12 && j >= 0 && j < 20)
                                 {
-                                    if(gridgetcell(d->usr_field, i, j + 2) != QRS_FIELD_W_LIMITER)
+                                    if(gridgetcell(d->field->usr_field, i, j + 2) != QRS_FIELD_W_LIMITER)
                                     {
                                         if(!d->field_edit_in_progress)
                                             usr_field_bkp(cs, d);
                                         d->field_edit_in_progress = 1;
                                         edit_action_occurred = 1;
-                                        gridsetcell(d->usr_field, i, j + 2, 0);
+                                        gridsetcell(d->field->usr_field, i, j + 2, 0);
                                     }
                                 }
                             }
@@ -779,17 +761,17 @@ int qrs_input(game_t *g)
                     {
                         if(i >= 0 && i < 12 && j >= 0 && j < 20)
                         {
-                            if(gridgetcell(d->usr_field, i, j + 2) != QRS_FIELD_W_LIMITER && c != QRS_PIECE_GEM)
+                            if(gridgetcell(d->field->usr_field, i, j + 2) != QRS_FIELD_W_LIMITER && c != QRS_PIECE_GEM)
                             {
                                 if(SDL_GetModState() & KMOD_SHIFT)
                                 {
-                                    if(IS_STACK(gridgetcell(d->usr_field, i, j + 2)))
+                                    if(IS_STACK(gridgetcell(d->field->usr_field, i, j + 2)))
                                     {
                                         if(!d->field_edit_in_progress)
                                             usr_field_bkp(cs, d);
                                         d->field_edit_in_progress = 1;
                                         edit_action_occurred = 1;
-                                        gridsetcell(d->usr_field, i, j + 2, c);
+                                        gridsetcell(d->field->usr_field, i, j + 2, c);
                                     }
                                 }
                                 else
@@ -798,20 +780,20 @@ int qrs_input(game_t *g)
                                         usr_field_bkp(cs, d);
                                     d->field_edit_in_progress = 1;
                                     edit_action_occurred = 1;
-                                    gridsetcell(d->usr_field, i, j + 2, c);
+                                    gridsetcell(d->field->usr_field, i, j + 2, c);
                                 }
                             }
-                            else if(gridgetcell(d->usr_field, i, j + 2) > 0 && c == QRS_PIECE_GEM)
+                            else if(gridgetcell(d->field->usr_field, i, j + 2) > 0 && c == QRS_PIECE_GEM)
                             {
                                 if(SDL_GetModState() & KMOD_SHIFT)
                                 {
-                                    if(IS_STACK(gridgetcell(d->usr_field, i, j + 2)))
+                                    if(IS_STACK(gridgetcell(d->field->usr_field, i, j + 2)))
                                     {
                                         if(!d->field_edit_in_progress)
                                             usr_field_bkp(cs, d);
                                         d->field_edit_in_progress = 1;
                                         edit_action_occurred = 1;
-                                        gridsetcell(d->usr_field, i, j + 2, gridgetcell(d->usr_field, i, j + 2) | c);
+                                        gridsetcell(d->field->usr_field, i, j + 2, gridgetcell(d->field->usr_field, i, j + 2) | c);
                                     }
                                 }
                                 else
@@ -820,7 +802,7 @@ int qrs_input(game_t *g)
                                         usr_field_bkp(cs, d);
                                     d->field_edit_in_progress = 1;
                                     edit_action_occurred = 1;
-                                    gridsetcell(d->usr_field, i, j + 2, gridgetcell(d->usr_field, i, j + 2) | c);
+                                    gridsetcell(d->field->usr_field, i, j + 2, gridgetcell(d->field->usr_field, i, j + 2) | c);
                                 }
                             }
                         }
@@ -833,17 +815,17 @@ int qrs_input(game_t *g)
             {
                 if(cell_x >= 0 && cell_x < 12 && cell_y >= 0 && cell_y < 20)
                 {
-                    if(gridgetcell(d->usr_field, cell_x, cell_y + 2) != QRS_FIELD_W_LIMITER && c != QRS_PIECE_GEM)
+                    if(gridgetcell(d->field->usr_field, cell_x, cell_y + 2) != QRS_FIELD_W_LIMITER && c != QRS_PIECE_GEM)
                     {
                         if(SDL_GetModState() & KMOD_SHIFT)
                         {
-                            if(IS_STACK(gridgetcell(d->usr_field, cell_x, cell_y + 2)))
+                            if(IS_STACK(gridgetcell(d->field->usr_field, cell_x, cell_y + 2)))
                             {
                                 if(!d->field_edit_in_progress)
                                     usr_field_bkp(cs, d);
                                 d->field_edit_in_progress = 1;
                                 edit_action_occurred = 1;
-                                gridsetcell(d->usr_field, cell_x, cell_y + 2, c);
+                                gridsetcell(d->field->usr_field, cell_x, cell_y + 2, c);
                             }
                         }
                         else
@@ -852,20 +834,20 @@ int qrs_input(game_t *g)
                                 usr_field_bkp(cs, d);
                             d->field_edit_in_progress = 1;
                             edit_action_occurred = 1;
-                            gridsetcell(d->usr_field, cell_x, cell_y + 2, c);
+                            gridsetcell(d->field->usr_field, cell_x, cell_y + 2, c);
                         }
                     }
-                    else if(gridgetcell(d->usr_field, cell_x, cell_y + 2) > 0 && c == QRS_PIECE_GEM)
+                    else if(gridgetcell(d->field->usr_field, cell_x, cell_y + 2) > 0 && c == QRS_PIECE_GEM)
                     {
                         if(SDL_GetModState() & KMOD_SHIFT)
                         {
-                            if(IS_STACK(gridgetcell(d->usr_field, cell_x, cell_y + 2)))
+                            if(IS_STACK(gridgetcell(d->field->usr_field, cell_x, cell_y + 2)))
                             {
                                 if(!d->field_edit_in_progress)
                                     usr_field_bkp(cs, d);
                                 d->field_edit_in_progress = 1;
                                 edit_action_occurred = 1;
-                                gridsetcell(d->usr_field, cell_x, cell_y + 2, gridgetcell(d->usr_field, cell_x, cell_y + 2) | c);
+                                gridsetcell(d->field->usr_field, cell_x, cell_y + 2, gridgetcell(d->field->usr_field, cell_x, cell_y + 2) | c);
                             }
                         }
                         else
@@ -874,14 +856,17 @@ int qrs_input(game_t *g)
                                 usr_field_bkp(cs, d);
                             d->field_edit_in_progress = 1;
                             edit_action_occurred = 1;
-                            gridsetcell(d->usr_field, cell_x, cell_y + 2, gridgetcell(d->usr_field, cell_x, cell_y + 2) | c);
+                            gridsetcell(d->field->usr_field, cell_x, cell_y + 2, gridgetcell(d->field->usr_field, cell_x, cell_y + 2) | c);
                         }
                     }
                 }
             }
 
-            if(!edit_action_occurred)
+            if(!edit_action_occurred && d->field_edit_in_progress)
+            {
+                usr_field_commit(cs, d);
                 d->field_edit_in_progress = 0;
+            }
         }
     }
 
@@ -1056,6 +1041,7 @@ int qrs_start_record(game_t *g)
     memset(q->replay->pinputs, 0, sizeof(struct packed_input) * MAX_KEYFLAGS);
 
     q->replay->len = 0;
+    q->replay->num_checkpoints = 0;
     q->replay->mlen = 36000;
     q->replay->mode = q->mode_type;
     q->replay->mode_flags = q->mode_flags;
@@ -1113,6 +1099,8 @@ int qrs_start_playback(game_t *g)
 
     q->playback = 1;
     q->playback_index = 0;
+    q->playback_checkpoint = 0;
+    q->desync_frame = -1;
 
     return 0;
 }
@@ -1246,54 +1234,24 @@ int qrs_wallkick(game_t *g, qrs_player *p)
     if(!g || !p)
         return -1;
 
+    qrsdata *q = (qrsdata *)g->data;
     piece_id c = p->def->qrs_id;
-    int o = p->orient;
-    int x = gridpostox(p->def->rotation_tables[0], qrs_chkcollision(g, p) - 1);
+    const struct qrs_shape *s = &qrs_shapes.pieces[c];
+    const struct qrs_shape_rot *r = &s->rot[p->orient];
+    int x = (qrs_chkcollision(g, p) - 1) % s->w;
     // printf("Trying to kick with collision at x = %d\n", x);
 
-    if(p->def->flags & PDNOWKICK)
+    if((p->def->flags & PDNOWKICK) && !(c == QRS_I4 && q->i4_wallkicks))
         return 1;
 
-    switch(c)
-    {
-        case QRS_I:
-        case QRS_I4:
-            if(o == CW || o == CCW)
-                return 1;
-            break;
-        case QRS_J:
-            if((o == CW || o == CCW) && x == 2)
-                return 1;
-            break;
-        case QRS_L:
-        case QRS_L4:
-        case QRS_J4:
-        case QRS_T4:
-            if((o == CW || o == CCW) && x == 1)
-                return 1;
-            break;
-        case QRS_N:
-        case QRS_G:
-        case QRS_Ya:
-        case QRS_Yb:
-            if(o == CW && x == 2)
-                return 1;
-            else if(o == CCW && x == 1)
-                return 1;
-            break;
-        default:
-            break;
-    }
+    if(x >= 0 && r->wallkick_block & (1 << x))
+        return 1;
 
     if(qrs_move(g, p, MOVE_RIGHT))
     {
         if(qrs_move(g, p, MOVE_LEFT))
         {
-            if(p->def->rotation_tables[0]->w == 4 && c != QRS_I4)
-                return 1;
-            if(c != QRS_I4 && c != QRS_I && c != QRS_J && c != QRS_L && c != QRS_Ya && c != QRS_Yb)
-                return 1;
-            if((c == QRS_J || c == QRS_L || c == QRS_Ya || c == QRS_Yb) && (p->orient == CW || p->orient == CCW))
+            if(!r->double_wallkick)
                 return 1;
 
             if(qrs_move(g, p, 2))
@@ -1310,7 +1268,8 @@ int qrs_wallkick(game_t *g, qrs_player *p)
 int qrs_hold(game_t *g, qrs_player *p)
 {
     qrsdata *q = (qrsdata *)g->data;
-    piecedef *temp = NULL;
+    const piecedef *temp = NULL;
+    unsigned int temp_flags = 0;
 
     if(!q->hold_enabled)
         return 1;
@@ -1320,11 +1279,12 @@ int qrs_hold(game_t *g, qrs_player *p)
 
     if(!q->hold)
     {
-        q->hold = piecedef_cpy(p->def);
+        q->hold = p->def;
+        q->hold_flags = p->def_flags;
         if(qs_initnext(g, p, INITNEXT_DURING_ACTIVE_PLAY) == 1)
         { // if there is no next piece to swap in
-            piecedef_destroy(q->hold);
             q->hold = NULL;
+            q->hold_flags = 0;
 
             return 1;
         }
@@ -1334,8 +1294,11 @@ int qrs_hold(game_t *g, qrs_player *p)
     else
     {
         temp = q->hold;
+        temp_flags = q->hold_flags;
         q->hold = p->def;
+        q->hold_flags = p->def_flags;
         p->def = temp;
+        p->def_flags = temp_flags;
 
         if(p->def->qrs_id >= 18) // tetrominoes spawn where they do in TGM
             p->y = ROWTOY(SPAWNY_QRS + 2);
@@ -1415,26 +1378,23 @@ int qrs_fall(game_t *g, qrs_player *p, int grav)
         grav = p->speeds->grav;
 
     int bkp_y = p->y;
+    int dist = qrs_drop_distance(g, p);
 
-    while(p->y < (bkp_y + grav))
+    // equivalent to stepping down one row at a time until we either collide or use up grav
+    if(dist * 256 < grav)
     {
-        p->y += 256;
-        if(qrs_chkcollision(g, p))
-        {
-            p->y -= (256 + (p->y & 255));
+        p->y = ROWTOY(YTOROW(bkp_y) + dist);
 
-            if(p->state & PSFALL && grav != 28 * 256)
-            {
-                sfx_play(&g->origin->assets->land);
-            }
-            p->state &= ~PSFALL;
-            p->state |= PSLOCK;
-            return -1;
+        if(p->state & PSFALL && grav != 28 * 256)
+        {
+            sfx_play(&g->origin->assets->land);
         }
+        p->state &= ~PSFALL;
+        p->state |= PSLOCK;
+        return -1;
     }
 
-    if(p->y - bkp_y > grav)
-        p->y = bkp_y + grav;
+    p->y = bkp_y + grav;
 
     return (YTOROW(p->y) - YTOROW(bkp_y));
 }
@@ -1446,7 +1406,6 @@ int qrs_lock(game_t *g, qrs_player *p)
 
     qrsdata *q = (qrsdata *)g->data;
     grid_t *d = p->def->rotation_tables[p->orient];
-    grid_t *f = g->field;
 
     int i = 0;
     int ax = ANCHORX_QRS;
@@ -1464,7 +1423,7 @@ int qrs_lock(game_t *g, qrs_player *p)
         if(gridgetcell(d, from_x, from_y))
         {
             int value = c + 1;
-            if(p->def->flags & PDBRACKETS)
+            if(p->def_flags & PDBRACKETS)
                 value |= QRS_PIECE_BRACKETS;
 
             if(q->state_flags & GAMESTATE_FADING)
@@ -1472,7 +1431,10 @@ int qrs_lock(game_t *g, qrs_player *p)
                 SET_PIECE_FADE_COUNTER(value, q->piece_fade_rate);
             }
 
-            gridsetcell(f, to_x, to_y, value);
+            qrs_setcell(g, to_x, to_y, value);
+
+            if(to_x >= 0 && to_x < QRS_FIELD_W && to_y >= 0 && to_y < q->field_tops[to_x])
+                q->field_tops[to_x] = to_y;
         }
     }
 
@@ -1488,37 +1450,31 @@ int qrs_chkcollision(game_t *g, qrs_player *p)
     if(!g || !p)
         return -1;
 
-    grid_t *d = p->def->rotation_tables[p->orient];
+    // pool pieces only, so the compile-time masks stand in for p->def->rotation_tables
+    const struct qrs_shape *s = &qrs_shapes.pieces[p->def->qrs_id];
+    const struct qrs_shape_rot *r = &s->rot[p->orient];
     grid_t *f = g->field;
     int d_x = 0;
     int d_y = 0;
-    int d_val = 0;
-    int f_x = 0;
-    int f_y = 0;
-    int f_val = 0;
+    int f_x = p->x - p->def->anchorx;
+    int f_y = YTOROW(p->y) - p->def->anchory;
     int i = 0;
-    int s = d->w * d->h;
 
-    for(i = 0; i < s; i++)
+    for(d_y = r->min_y; d_y <= r->max_y; d_y++)
     {
-        d_x = gridpostox(d, i);
-        d_y = gridpostoy(d, i);
-        f_x = p->x - p->def->anchorx + d_x;
-        f_y = YTOROW(p->y) - p->def->anchory + d_y;
-
-        d_val = gridgetcell(d, d_x, d_y);
-        f_val = gridgetcell(f, f_x, f_y);
-
-        // printf("Checking piecedef val %d against %d at position %d (field y = %d)\n", d_val, f_val, i, f_y);
-
-        if(d_val && f_val)
+        for(d_x = r->left[d_y]; d_x <= r->right[d_y]; d_x++)
         {
-            // gridgetcell returns 8128 on out of bounds, so it will default to collision = true
+            i = d_y * s->w + d_x;
+
+            if(r->mask & (1u << i) && gridgetcell(f, f_x + d_x, f_y + d_y))
+            {
+                // gridgetcell returns 8128 on out of bounds, so it will default to collision = true
 
-            // the +1 slightly confuses things, but is required for cases where the collision is at position = 0
-            // this way we don't return 0 (== no collision) when there in fact was a collision
-            // TODO put in a macro for QRS_COLLISION_FALSE, set it to some non-zero value
-            return i + 1;
+                // the +1 slightly confuses things, but is required for cases where the collision is at position = 0
+                // this way we don't return 0 (== no collision) when there in fact was a collision
+                // TODO put in a macro for QRS_COLLISION_FALSE, set it to some non-zero value
+                return i + 1;
+            }
         }
     }
 
@@ -1543,52 +1499,184 @@ int qrs_isonground(game_t *g, qrs_player *p)
     return 0;
 }
 
+int qrs_drop_distance(game_t *g, qrs_player *p)
+{
+    if(!g || !p)
+        return -1;
+
+    qrsdata *q = (qrsdata *)g->data;
+    grid_t *d = p->def->rotation_tables[p->orient];
+    const int *bottom = p->def->bottom_profiles[p->orient];
+    int bkp_y = p->y;
+    int dist = QRS_FIELD_H;
+    int i = 0;
+    int x = 0;
+    int y = 0;
+
+    if(d->w <= PD_PROFILE_W)
+    {
+        for(i = 0; i < d->w; i++)
+        {
+            if(bottom[i] < 0)
+                continue;
+
+            x = p->x - p->def->anchorx + i;
+            y = YTOROW(p->y) - p->def->anchory + bottom[i];
+
+            // the piece is tucked under part of the stack in this column, so the surface tells us nothing
+            if(x < 0 || x >= QRS_FIELD_W || y >= q->field_tops[x])
+                break;
+
+            if(q->field_tops[x] - y - 1 < dist)
+                dist = q->field_tops[x] - y - 1;
+        }
+
+        if(i == d->w)
+            return dist;
+    }
+
+    dist = 0;
+
+    for(p->y += 256; !qrs_chkcollision(g, p); p->y += 256)
+        dist++;
+
+    p->y = bkp_y;
+
+    return dist;
+}
+
+static uint32_t field_cell_hash(int x, int val)
+{
+    uint32_t h = (uint32_t)val * 0x9e3779b1u + (uint32_t)x;
+
+    h ^= h >> 16;
+    h *= 0x85ebca6bu;
+    h ^= h >> 13;
+
+    return h;
+}
+
+static void field_counts_add(struct field_counts *fc, int x, int y, int val, int amount)
+{
+    if(!val || val == GRID_OOB || val == QRS_FIELD_W_LIMITER)
+        return;
+
+    // adding and removing a cell are the same XOR
+    fc->row_hash[y] ^= field_cell_hash(x, val);
+
+    fc->cells += amount;
+    fc->row_cells[y] += amount;
+
+    if(val == QRS_PIECE_GARBAGE)
+    {
+        fc->garbage += amount;
+        fc->row_garbage[y] += amount;
+    }
+    else if(val > 0 && (val & QRS_PIECE_GEM))
+    {
+        fc->gems += amount;
+        fc->row_gems[y] += amount;
+    }
+}
+
+int qrs_setcell(game_t *g, int x, int y, int val)
+{
+    if(!g)
+        return -1;
+
+    qrsdata *q = (qrsdata *)g->data;
+    int old = gridgetcell(g->field, x, y);
+
+    if(old == GRID_OOB)
+        return GRID_OOB;
+
+    field_counts_add(&q->field_counts, x, y, old, -1);
+    field_counts_add(&q->field_counts, x, y, val, 1);
+
+    return gridsetcell(g->field, x, y, val);
+}
+
+int qrs_update_field_counts(game_t *g)
+{
+    if(!g)
+        return -1;
+
+    qrsdata *q = (qrsdata *)g->data;
+    int i = 0;
+    int j = 0;
+
+    memset(&q->field_counts, 0, sizeof(struct field_counts));
+
+    for(i = 0; i < QRS_FIELD_W; i++)
+    {
+        for(j = 0; j < QRS_FIELD_H; j++)
+            field_counts_add(&q->field_counts, i, j, gridgetcell(g->field, i, j), 1);
+    }
+
+    return 0;
+}
+
+int qrs_update_field_tops(game_t *g)
+{
+    if(!g)
+        return -1;
+
+    qrsdata *q = (qrsdata *)g->data;
+    int i = 0;
+    int j = 0;
+
+    for(i = 0; i < QRS_FIELD_W; i++)
+    {
+        for(j = 0; j < QRS_FIELD_H; j++)
+        {
+            if(gridgetcell(g->field, i, j))
+                break;
+        }
+
+        q->field_tops[i] = j;
+    }
+
+    return 0;
+}
+
 int qrs_lineclear(game_t *g, qrs_player *p)
 {
     if(!g || !p)
         return -1;
 
     qrsdata *q = (qrsdata *)g->data;
+    struct field_counts *fc = &q->field_counts;
 
     int i = 0;
     int j = 0;
-    int k = 0;
-    int n = 0;
-    int garbage = 0;
     bool gem = false;
 
     int row = YTOROW(p->y);
 
-    for(i = row - 1; (i < row + 4) && (i < QRS_FIELD_H); i++)
+    q->num_cleared_rows = 0;
+
+    for(i = (row > 0 ? row - 1 : 0); (i < row + 4) && (i < QRS_FIELD_H); i++)
     {
-        k = 0;
-        garbage = 0;
+        // rows made up entirely of garbage don't clear
+        if(fc->row_cells[i] != q->field_w || fc->row_garbage[i] == q->field_w)
+            continue;
 
+        q->cleared_rows[q->num_cleared_rows] = i;
+        q->num_cleared_rows++;
+
+        gem = fc->row_gems[i] > 0;
+
+        gfx_qs_lineclear(g, i);
         for(j = (QRS_FIELD_W - q->field_w) / 2; j < (QRS_FIELD_W / 2 + q->field_w / 2); j++)
-        {
-            if(gridgetcell(g->field, j, i))
-                k++;
-            if(gridgetcell(g->field, j, i) & QRS_PIECE_GEM)
-                gem = true;
-            if(gridgetcell(g->field, j, i) == QRS_PIECE_GARBAGE)
-                garbage++;
-        }
+            qrs_setcell(g, j, i, -2);
 
-        if(k == q->field_w && garbage != q->field_w)
+        if(gem)
         {
-            n++;
-            gfx_qs_lineclear(g, i);
-            for(j = (QRS_FIELD_W - q->field_w) / 2; j < (QRS_FIELD_W / 2 + q->field_w / 2); j++)
-                gridsetcell(g->field, j, i, -2);
-
-            if(gem)
-            {
-                // sfx_play(&g->origin->assets->gem) the gem clear sound effect whenever we get one
-            }
+            // sfx_play(&g->origin->assets->gem) the gem clear sound effect whenever we get one
         }
     }
 
-    return n;
+    return q->num_cleared_rows;
 }
 
 int qrs_dropfield(game_t *g)
@@ -1597,28 +1685,48 @@ int qrs_dropfield(game_t *g)
         return -1;
 
     qrsdata *q = (qrsdata *)g->data;
-    grid_t *field = g->field;
 
+    if(!q->num_cleared_rows)
+        return 0;
+
+    struct field_counts *fc = &q->field_counts;
     int i = 0;
-    int j = 0;
-    int n = 0;
+    int k = q->num_cleared_rows - 1;
+    int dest = q->cleared_rows[k];
 
-    for(i = QRS_FIELD_H - 1; i > 0; i--)
-    {
-        while(gridgetcell(field, 6, i - n) == -2)
-            n++;
+    // rows were recorded top to bottom, which is the order grid_remove_rows() wants
+    grid_remove_rows(g->field, q->cleared_rows, q->num_cleared_rows, (QRS_FIELD_W - q->field_w) / 2, QRS_FIELD_W / 2 + q->field_w / 2);
 
-        if(i - n >= 0)
-            gridrowcpy(field, NULL, i - n, i);
-        else
+    // the cleared rows only hold -2 by now, so only the filled count needs adjusting
+    // the per-row counts get compacted the same way as the rows themselves
+    for(i = dest; i >= 0; i--)
+    {
+        if(k >= 0 && q->cleared_rows[k] == i)
         {
-            for(j = (QRS_FIELD_W - q->field_w) / 2; j < (QRS_FIELD_W / 2 + q->field_w / 2); j++)
-            {
-                gridsetcell(field, j, i, 0);
-            }
+            fc->cells -= fc->row_cells[i];
+            k--;
+            continue;
         }
+
+        fc->row_cells[dest] = fc->row_cells[i];
+        fc->row_garbage[dest] = fc->row_garbage[i];
+        fc->row_gems[dest] = fc->row_gems[i];
+        fc->row_hash[dest] = fc->row_hash[i];
+        dest--;
+    }
+
+    for(; dest >= 0; dest--)
+    {
+        fc->row_cells[dest] = 0;
+        fc->row_garbage[dest] = 0;
+        fc->row_gems[dest] = 0;
+        fc->row_hash[dest] = 0;
     }
 
+    q->num_cleared_rows = 0;
+
+    qrs_update_field_tops(g);
+
     return 0;
 }
 
@@ -1626,31 +1734,91 @@ int qrs_spawn_garbage(game_t *g, unsigned int flags)
 {
     qrsdata *q = (qrsdata *)g->data;
     int i = 0;
+    int val = 0;
+    bool tops_invalid = false;
 
-    if(q->garbage)
+    if(!q->garbage && !(flags & GARBAGE_COPY_BOTTOM_ROW))
     {
-        // TODO
+        // random garbage based on several factors (TODO)
+        return 0;
     }
-    else if(flags & GARBAGE_COPY_BOTTOM_ROW)
+
+    struct field_counts *fc = &q->field_counts;
+
+    // the top row is about to be pushed out of the field
+    fc->cells -= fc->row_cells[0];
+    fc->garbage -= fc->row_garbage[0];
+    fc->gems -= fc->row_gems[0];
+
+    for(i = 0; i < QRS_FIELD_H - 1; i++)
     {
-        for(i = 0; i < 21; i++)
-        {
-            gridrowcpy(g->field, NULL, i + 1, i);
-        }
+        fc->row_cells[i] = fc->row_cells[i + 1];
+        fc->row_garbage[i] = fc->row_garbage[i + 1];
+        fc->row_gems[i] = fc->row_gems[i + 1];
+        fc->row_hash[i] = fc->row_hash[i + 1];
+    }
 
-        gridrowcpy(g->field, NULL, 20, 21);
-        for(i = 0; i < QRS_FIELD_W; i++)
-        {
-            if(gridgetcell(g->field, i, 20) == QRS_FIELD_W_LIMITER)
-                continue;
-            if(gridgetcell(g->field, i, 20))
-                gridsetcell(g->field, i, 21, QRS_PIECE_GARBAGE);
-        }
+    fc->row_cells[QRS_FIELD_H - 1] = 0;
+    fc->row_garbage[QRS_FIELD_H - 1] = 0;
+    fc->row_gems[QRS_FIELD_H - 1] = 0;
+    fc->row_hash[QRS_FIELD_H - 1] = 0;
+
+    // everything moves up a row; the old top row wraps around to the bottom, where it is overwritten with the new garbage
+    grid_rotate_rows(g->field, 1);
+
+    for(i = (QRS_FIELD_W - q->field_w) / 2; i < (QRS_FIELD_W / 2 + q->field_w / 2); i++)
+    {
+        if(q->garbage)
+            val = gridgetcell(q->garbage, i, q->garbage_row_index) ? QRS_PIECE_GARBAGE : 0;
+        else
+            val = gridgetcell(g->field, i, QRS_FIELD_H - 2) ? QRS_PIECE_GARBAGE : 0;
+
+        gridsetcell(g->field, i, QRS_FIELD_H - 1, val);
+        field_counts_add(fc, i, QRS_FIELD_H - 1, val, 1);
+
+        if(q->field_tops[i] == 0)
+            tops_invalid = true; // the top row was pushed out of the field
+        else if(q->field_tops[i] < QRS_FIELD_H)
+            q->field_tops[i]--;
+        else if(val)
+            q->field_tops[i] = QRS_FIELD_H - 1;
     }
-    else
+
+    if(tops_invalid)
+        qrs_update_field_tops(g);
+
+    if(q->garbage)
     {
-        // random garbage based on several factors (TODO)
+        q->garbage_row_index++;
+        if(q->garbage_row_index >= q->garbage->h)
+            q->garbage_row_index = 0;
     }
 
     return 0;
 }
+
+grid_t *qrs_garbage_seq_create(int field_w)
+{
+    if(field_w % 2 || field_w < 4 || field_w > QRS_FIELD_W)
+        return NULL;
+
+    // one hole per row, walking across the field and back
+    grid_t *g = grid_create(QRS_FIELD_W, 2 * (field_w - 1));
+    int left = (QRS_FIELD_W - field_w) / 2;
+    int hole = 0;
+    int x = 0;
+    int y = 0;
+
+    for(y = 0; y < g->h; y++)
+    {
+        hole = y < field_w ? y : 2 * (field_w - 1) - y;
+
+        for(x = 0; x < field_w; x++)
+        {
+            if(x != hole)
+                gridsetcell(g, left + x, y, QRS_PIECE_GARBAGE);
+        }
+    }
+
+    return g;
+}
@@ -129,6 +129,9 @@
 
 #define GARBAGE_COPY_BOTTOM_ROW        0x0001
 
+// a piece spans at most 5 rows
+#define QRS_MAX_LINECLEAR 5
+
 #define SPAWNX_QRS 5
 #define SPAWNY_QRS 1
 
@@ -181,9 +184,26 @@ typedef struct
     int hold_flash;
 } qrs_counters;
 
+// live cell counts of g->field, walls (QRS_FIELD_W_LIMITER) not included
+// rows marked for clearing (-2) count as filled until qrs_dropfield() removes them
+struct field_counts
+{
+    int cells;
+    int garbage;
+    int gems;
+
+    int row_cells[QRS_FIELD_H];
+    int row_garbage[QRS_FIELD_H];
+    int row_gems[QRS_FIELD_H];
+
+    // XOR of a hash of each cell's column and value; rows move around without rehashing (see qs_state_hash())
+    uint32_t row_hash[QRS_FIELD_H];
+};
+
 typedef struct
 {
-    piecedef *def;
+    const piecedef *def;    // shared entry of qrsdata::piecepool, never owned
+    unsigned int def_flags;    // per-instance flags of the active piece (PDBRACKETS)
     qrs_timings *speeds;
     unsigned int state;        // rename?
 
@@ -192,6 +212,65 @@ typedef struct
     int orient;
 } qrs_player;
 
+#define FIELD_HISTORY_MAX_EDITS 256
+#define FIELD_HISTORY_MAX_CELLS 4096    // a full-field edit is 12 * 22 cells, so always at least 15 of those
+
+struct field_edit_cell
+{
+    int8_t x;
+    int8_t y;
+    int old_val;
+    int new_val;
+};
+
+struct field_edit
+{
+    int first_cell;    // index into field_history::cells; an edit's cells may wrap around the end
+    int num_cells;
+};
+
+/* undo/redo of the practice field editor: one record of changed cells per mouse stroke, in two fixed rings
+   the oldest edits are dropped once either ring is full, so long sessions never allocate or grow */
+struct field_history
+{
+    struct field_edit edits[FIELD_HISTORY_MAX_EDITS];
+    struct field_edit_cell cells[FIELD_HISTORY_MAX_CELLS];
+
+    int first_edit;    // oldest edit still held
+    int num_undo;      // edits from first_edit on that can be undone..
+    int num_redo;      // ..followed by the ones that can be redone
+    int num_cells;     // cells used by all of them
+};
+
+#define USRSEQ_COUNT_INF -1
+
+// one run of usr_sequence elements, played count times in a row
+struct usrseq_op
+{
+    int first;    // index of the run's first element in usr_sequence
+    int len;
+    int count;    // USRSEQ_COUNT_INF repeats forever, and is always the last op
+    int start;    // index of the run's first piece in the sequence the player gets (2000 * USRSEQ_RPTCOUNT_MAX at most)
+};
+
+// the parts of struct pracdata the sequence and field editors work on
+struct pracdata_seq
+{
+    int usr_sequence[2000];
+    int usr_seq_len;
+
+    // usr_sequence with its repeat markers compiled by qs_compile_usrseq(), so pieces can be looked up without expanding it
+    struct usrseq_op *usr_seq_ops;    // one per usr_sequence element at most, so sized from usr_seq_len when compiled
+    int usr_seq_num_ops;
+};
+
+struct pracdata_field
+{
+    grid_t *usr_field;
+    grid_t *usr_field_stroke;    // usr_field as it was when the edit in progress started
+    struct field_history *history;
+};
+
 struct pracdata
 {
     int game_type;    // mirrors of values in qrsdata; these are just here so that..
@@ -201,18 +280,10 @@ struct pracdata
                                 // going to re-add long_history but with placement locations included,
                                 // as well as game time/level, to allow piece-by-piece rewinds
 
-    int usr_sequence[2000];
-    int usr_seq_expand[4000];
-    int usr_seq_len;
-    int usr_seq_expand_len;
-
-    grid_t **usr_field_undo;
-    grid_t **usr_field_redo;
-    int usr_field_undo_len;
-    int usr_field_redo_len;
+    struct pracdata_seq *seq;
+    struct pracdata_field *field;
     bool field_edit_in_progress;
 
-    grid_t *usr_field;
     int palette_selection;
     int field_selection;
     int field_selection_vertex1_x;
@@ -230,6 +301,7 @@ struct pracdata
     int hist_index;
     int lock_protect;
     bool infinite_floorkicks;
+    int garbage_delay;    // pieces between rows of qrs_garbage_seq_create() rising up, 0 for none
     int piece_subset;
 
     long randomizer_seed;
@@ -237,18 +309,20 @@ struct pracdata
 
 typedef struct
 {
-    piecedef **piecepool;
+    const piecedef **piecepool;    // built by qrspool_create(), shared by every piece in play and never changed
     struct randomizer *randomizer;
     struct pracdata *pracdata;
     struct replay *replay;
-    grid_t *garbage;
+    grid_t *garbage;    // optional garbage sequence, QRS_FIELD_W wide; nonzero cells of each row become garbage as it rises
     piece_id *piece_seq;
 
     nz_timer *timer;
     qrs_player *p1;
     qrs_counters *p1counters;
-    piecedef *previews[3];
-    piecedef *hold;
+    const piecedef *previews[3];
+    const piecedef *hold;
+    unsigned int preview_flags[3];
+    unsigned int hold_flags;
 
 // fields which are assumed to be read-only during normal gameplay
 
@@ -273,6 +347,7 @@ typedef struct
     int field_w; // in cells (only player-accessible ones counted here)
 
     unsigned int max_floorkicks;
+    bool i4_wallkicks;    // overrides the PDNOWKICK in the I4's pool entry
     int num_previews;
 
     bool lock_delay_enabled;
@@ -291,7 +366,21 @@ typedef struct
 
     int piece_seq_index;
     int garbage_row_index;    // which row of the garbage grid to spawn next
+
+    // row of the highest occupied cell in each column of g->field (QRS_FIELD_H if the column is empty)
+    // kept up to date by qrs_lock(), qrs_dropfield() and qrs_spawn_garbage(); call qrs_update_field_tops() after any other field edit
+    int field_tops[QRS_FIELD_W];
+
+    // kept up to date by qrs_setcell(), qrs_dropfield() and qrs_spawn_garbage(); call qrs_update_field_counts() after any other field edit
+    struct field_counts field_counts;
+
+    // rows marked for clearing (with -2) by qrs_lineclear(), top to bottom; consumed by qrs_dropfield()
+    int cleared_rows[QRS_MAX_LINECLEAR];
+    int num_cleared_rows;
     int playback_index;        // equivalent to number of frames that input has been handled in the game so far
+    int playback_checkpoint;    // next entry of replay->checkpoints to check during playback
+    int desync_frame;    // first playback frame whose state hash differs from the recording, -1 if none so far
+    uint32_t state_hash;    // qs_state_hash() as of the last frame recorded or played back
 
     // increments for each piece that doesnt clear lines (shirase: for each piece spawned & decrements for each line cleared)
     int garbage_counter;
@@ -365,8 +454,12 @@ const char *get_qrspiece_name(int n);
 void qrsdata_destroy(qrsdata *q);
 void pracdata_destroy(struct pracdata *d);
 
-piecedef **qrspool_create();
-piecedef *qrspiece_cpy(piecedef **piecepool, int index);
+struct pracdata_seq *pracdata_seq_create();
+struct pracdata_field *pracdata_field_create();
+
+const piecedef **qrspool_create();
+void qrspool_destroy(const piecedef **pool);
+const piecedef *qrspiece_get(const piecedef **piecepool, int index);
 
 grid_t *qrsfield_create();
 int qrsfield_set_w(grid_t *field, int w);
@@ -374,7 +467,11 @@ int qrsfield_clear(grid_t *field);
 
 int ufu_not_exists(coreState *cs);
 
+struct field_history *field_history_create();
+void field_history_destroy(struct field_history *h);
+
 int usr_field_bkp(coreState *cs, struct pracdata *d);
+int usr_field_commit(coreState *cs, struct pracdata *d);
 int usr_field_undo(coreState *cs, struct pracdata *d);
 int usr_field_redo(coreState *cs, struct pracdata *d);
 int push_undo_clear_confirm(coreState *cs, void *data);
@@ -404,9 +501,14 @@ int qrs_fall(game_t *g, qrs_player *p, int grav);
 int qrs_lock(game_t *g, qrs_player *p);
 int qrs_chkcollision(game_t *g, qrs_player *p);
 int qrs_isonground(game_t *g, qrs_player *p);
+int qrs_drop_distance(game_t *g, qrs_player *p);
+int qrs_update_field_tops(game_t *g);
+int qrs_update_field_counts(game_t *g);
+int qrs_setcell(game_t *g, int x, int y, int val);
 
 int qrs_lineclear(game_t *g, qrs_player *p);
 int qrs_dropfield(game_t *g);
 int qrs_spawn_garbage(game_t *g, unsigned int flags);
+grid_t *qrs_garbage_seq_create(int field_w);
 
 #endif
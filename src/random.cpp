@@ -1,4 +1,5 @@
 #include "random.h"
+#include "game_qs.h"
 #include "qrs.h"
 #include <math.h>
 #include <stdbool.h>
@@ -133,38 +134,29 @@ void g123_seeds_init()
     pento_seed = g2_rand((s << 4) % 11456);
 }
 
-/*
 int seeds_are_close(uint32_t s1, uint32_t s2, unsigned int max_gap)
 {
-    unsigned int i = 0;
-    uint32_t s1_tmp_forward = s1;
-    uint32_t s1_tmp_backward = s1;
+    uint32_t dist = g2_seed_distance(s1, s2);
 
-    for(i = 0; i < max_gap; i++) {
-        s1_tmp_forward = g2_rand(s1_tmp_forward);
-        if(s1_tmp_forward == s2)
-            return 1;
+    if(dist == 0)
+        return 0;
 
-        s1_tmp_backward = g2_unrand(s1_tmp_backward);
-        if(s1_tmp_backward == s2)
-            return 1;
-    }
+    // the LCG has full period, so stepping backward d times is stepping forward 2^32 - d times
+    if(dist <= max_gap || (uint32_t)(0u - dist) <= max_gap)
+        return 1;
 
     return 0;
 }
 
 int seed_is_after(uint32_t b, uint32_t a, unsigned int max_gap)
 {
-    unsigned int i = 0;
-    for(i = 0; i < max_gap; i++) {
-        a = g2_rand(a);
-        if(a == b)
-            return 1;
-    }
+    uint32_t dist = g2_seed_distance(a, b);
 
-    return 0;
+    if(dist == 0 || dist > max_gap)
+        return 0;
+
+    return 1;
 }
-*/
 
 /*
 char *sprintf_rngstate(char *strbuf, rngstate s)
@@ -266,7 +258,7 @@ struct randomizer *g3_randomizer_create(uint32_t flags)
         d->bag[i] = PIECE_ID_INVALID;
 
     for(i = 0; i < 7; i++)
-        d->histogram[0] = 0;
+        d->histogram[i] = 0;
 
     return r;
 }
@@ -314,6 +306,37 @@ struct randomizer *pento_randomizer_create(uint32_t flags)
     return r;
 }
 
+struct randomizer *thread_randomizer_create(int randomizer_type, uint32_t *seedp)
+{
+    struct randomizer *r = NULL;
+
+    switch(randomizer_type)
+    {
+        case RANDOMIZER_NORMAL:
+            r = pento_randomizer_create(0);
+            break;
+        case RANDOMIZER_NIGHTMARE:
+            r = pento_randomizer_create(PENTO_RAND_NIGHTMARE);
+            break;
+        case RANDOMIZER_G1:
+            r = g1_randomizer_create(0);
+            break;
+        case RANDOMIZER_G2:
+            r = g2_randomizer_create(0);
+            break;
+        case RANDOMIZER_G3:
+            r = g3_randomizer_create(0);
+            break;
+        default:
+            return NULL;
+    }
+
+    if(seedp)
+        r->seedp = seedp;
+
+    return r;
+}
+
 void randomizer_destroy(struct randomizer *r)
 {
     if(!r)
@@ -362,13 +385,13 @@ int g1_randomizer_init(struct randomizer *r, uint32_t *seed)
     if(seed)
     {
         g1_bkp_seed = g1_seed;
-        g1_seed = *seed;
+        *r->seedp = *seed;
     }
 
     d->history[0] = ARS_Z;
     d->history[1] = ARS_Z;
     d->history[2] = ARS_Z;
-    d->history[3] = g123_get_init_piece(&g1_seed);
+    d->history[3] = g123_get_init_piece(r->seedp);
     num_generated = 1;
 
     for(i = 0; i < 3; i++) // move init piece to history[0] (first preview/next piece) and fill in 3 pieces ahead
@@ -389,13 +412,13 @@ int g2_randomizer_init(struct randomizer *r, uint32_t *seed)
     if(seed)
     {
         g2_bkp_seed = g2_seed;
-        g2_seed = *seed;
+        *r->seedp = *seed;
     }
 
     d->history[0] = ARS_S;
     d->history[1] = ARS_S;
     d->history[2] = ARS_Z;
-    d->history[3] = g123_get_init_piece(&g2_seed);
+    d->history[3] = g123_get_init_piece(r->seedp);
     num_generated = 1;
 
     for(i = 0; i < 3; i++)
@@ -418,7 +441,7 @@ int g3_randomizer_init(struct randomizer *r, uint32_t *seed)
     if(seed)
     {
         g3_bkp_seed = g3_seed;
-        g3_seed = *seed;
+        *r->seedp = *seed;
     }
 
     for(i = 0; i < 35; i++)
@@ -451,7 +474,7 @@ int pento_randomizer_init(struct randomizer *r, uint32_t *seed)
     if(seed)
     {
         pento_bkp_seed = pento_seed;
-        pento_seed = *seed;
+        *r->seedp = *seed;
     }
 
     d->history[0] = QRS_Fb;
@@ -576,8 +599,8 @@ piece_id histrand_get_next(struct randomizer *r)
     long double p = 0.0;
     double old_sum = 0.0;
     double sum = 0.0;
-    unsigned int *histogram = (unsigned int *)malloc(r->num_pieces * sizeof(unsigned int));
-    double *temp_weights = (double *)malloc(r->num_pieces * sizeof(double));
+    unsigned int *histogram = NULL;
+    double *temp_weights = NULL;
 
     if(!seedp)
         seedp = &g2_seed;
@@ -601,9 +624,6 @@ piece_id histrand_get_next(struct randomizer *r)
             t = g123_read_rand(seedp) % 7;
         }
 
-        free(temp_weights);
-        free(histogram);
-
         return t;
     }
 
@@ -612,6 +632,9 @@ piece_id histrand_get_next(struct randomizer *r)
         // starts at 1 and counts up, bad pieces' weights are divided by this
         int below_threshold = 1;
 
+        histogram = (unsigned int *)malloc(r->num_pieces * sizeof(unsigned int));
+        temp_weights = (double *)malloc(r->num_pieces * sizeof(double));
+
         for(i = 0; i < r->num_pieces; i++)
         {
             temp_weights[i] = d->piece_weights[i];
@@ -675,6 +698,9 @@ piece_id histrand_get_next(struct randomizer *r)
             // find which segment p is in
             if(p >= (long double)(sum) && p < (long double)(sum + temp_weights[i]))
             {
+                free(temp_weights);
+                free(histogram);
+
                 return i;
             }
             else
@@ -891,32 +917,59 @@ uint32_t g2_rand(uint32_t n) { return (n * 0x41c64e6d + 12345); }
 
 uint32_t g2_rand_rep(uint32_t n, uint32_t reps)
 {
-    if(reps == 0)
-        return n;
+    uint32_t mult = 0x41c64e6d;
+    uint32_t plus = 12345;
+    uint32_t acc_mult = 1;
+    uint32_t acc_plus = 0;
 
-    if(reps == 1)
-        return g2_rand(n);
+    // compose the LCG with itself by repeated squaring: f^(2k)(n) = f^k(f^k(n))
+    while(reps)
+    {
+        if(reps & 1)
+        {
+            acc_mult *= mult;
+            acc_plus = acc_plus * mult + plus;
+        }
 
-    uint32_t rr = g2_rand(n);
-    uint32_t result = g2_rand_rep(rr, reps - 1);
+        plus = (mult + 1) * plus;
+        mult *= mult;
+        reps >>= 1;
+    }
 
-    return result;
+    return acc_mult * n + acc_plus;
 }
 
 uint32_t g2_unrand(uint32_t n) { return ((n - 12345) * 0xeeb9eb65); }
 
 uint32_t g2_unrand_rep(uint32_t n, uint32_t reps)
 {
-    if(reps == 0)
-        return n;
+    // full period: stepping back reps times is stepping forward 2^32 - reps times
+    return g2_rand_rep(n, 0u - reps);
+}
 
-    if(reps == 1)
-        return g2_unrand(n);
+uint32_t g2_seed_distance(uint32_t from, uint32_t to)
+{
+    uint32_t mult = 0x41c64e6d;
+    uint32_t plus = 12345;
+    uint32_t bit = 1;
+    uint32_t dist = 0;
+
+    // bit k of the state only depends on bits 0..k of the state and of the step count,
+    // so the step count can be recovered one bit at a time from the bottom up
+    while(from != to)
+    {
+        if((from & bit) != (to & bit))
+        {
+            from = from * mult + plus;
+            dist |= bit;
+        }
 
-    uint32_t un = g2_unrand(n);
-    uint32_t result = g2_unrand_rep(un, reps - 1);
+        bit <<= 1;
+        plus = (mult + 1) * plus;
+        mult *= mult;
+    }
 
-    return result;
+    return dist;
 }
 
 uint32_t g123_read_rand(uint32_t *seedp)
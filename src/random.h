@@ -140,6 +140,8 @@ struct randomizer *g1_randomizer_create(uint32_t flags);
 struct randomizer *g2_randomizer_create(uint32_t flags);
 struct randomizer *g3_randomizer_create(uint32_t flags);
 struct randomizer *pento_randomizer_create(uint32_t flags);
+// any of the RANDOMIZER_* types, stepping *seedp instead of the global seeds so one can be run per thread
+struct randomizer *thread_randomizer_create(int randomizer_type, uint32_t *seedp);
 void randomizer_destroy(struct randomizer *r);
 
 /* _init functions prepare a randomizer for the beginning of a new game
@@ -186,6 +188,9 @@ uint32_t g2_rand_rep(uint32_t n, uint32_t reps);
 uint32_t g2_unrand_rep(uint32_t n, uint32_t reps);
 uint32_t g2_unrand(uint32_t n);
 
+// number of g2_rand() steps from one seed to another, in O(log n)
+uint32_t g2_seed_distance(uint32_t from, uint32_t to);
+
 uint32_t g123_read_rand(uint32_t *seedp);
 uint32_t pento_read_rand(uint32_t *seedp);
 piece_id g123_get_init_piece(uint32_t *seedp);
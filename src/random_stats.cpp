@@ -0,0 +1,271 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+
+#include "debug.h"
+#include "game_qs.h"
+#include "random.h"
+#include "random_stats.h"
+
+// indexed by ARS piece id (I, Z, S, J, L, O, T)
+static double ars_piece_weights[7] = {ARS_I_WEIGHT, ARS_Z_WEIGHT, ARS_S_WEIGHT, ARS_J_WEIGHT, ARS_L_WEIGHT, ARS_O_WEIGHT, ARS_T_WEIGHT};
+
+struct random_stats_worker
+{
+    struct random_stats *rs;
+    uint32_t seed;
+    uint64_t num_pulls;
+
+    uint64_t counts[RANDOM_STATS_MAX_PIECES];
+    uint64_t droughts[RANDOM_STATS_MAX_PIECES][RANDOM_STATS_DROUGHT_BINS];
+    unsigned int max_drought[RANDOM_STATS_MAX_PIECES];
+    uint64_t repeats;
+    uint64_t history_repeats;
+};
+
+static struct randomizer *random_stats_randomizer_create(struct random_stats *rs, uint32_t *seedp)
+{
+    struct randomizer *r = thread_randomizer_create(rs->randomizer_type, seedp);
+
+    if(r && r->type == HISTRAND && ((struct histrand_data *)r->data)->piece_weights)
+        histrand_set_difficulty(r, rs->difficulty);
+
+    return r;
+}
+
+static int random_stats_thread(void *data)
+{
+    struct random_stats_worker *w = (struct random_stats_worker *)data;
+    struct randomizer *r = random_stats_randomizer_create(w->rs, &w->seed);
+    uint64_t last_seen[RANDOM_STATS_MAX_PIECES];
+    piece_id recent[4] = {PIECE_ID_INVALID, PIECE_ID_INVALID, PIECE_ID_INVALID, PIECE_ID_INVALID};
+    piece_id t = PIECE_ID_INVALID;
+    unsigned int gap = 0;
+    uint64_t n = 0;
+    unsigned int i = 0;
+
+    if(!r)
+        return 1;
+
+    r->init(r, NULL);
+
+    for(i = 0; i < RANDOM_STATS_MAX_PIECES; i++)
+        last_seen[i] = 0;
+
+    for(n = 0; n < w->num_pulls; n++)
+    {
+        t = r->pull(r);
+        if(t >= RANDOM_STATS_MAX_PIECES)
+            continue;
+
+        w->counts[t]++;
+
+        // droughts are measured in pulls since the piece last came up (or since the start)
+        gap = (unsigned int)(n - last_seen[t]);
+        last_seen[t] = n;
+        if(gap > w->max_drought[t])
+            w->max_drought[t] = gap;
+
+        w->droughts[t][gap < RANDOM_STATS_DROUGHT_BINS ? gap : RANDOM_STATS_DROUGHT_BINS - 1]++;
+
+        if(t == recent[3])
+            w->repeats++;
+
+        if(in_history(recent, 4, t))
+            w->history_repeats++;
+
+        history_push(recent, 4, t);
+    }
+
+    randomizer_destroy(r);
+
+    return 0;
+}
+
+int random_stats_run(struct random_stats *rs)
+{
+    struct random_stats_worker *workers = NULL;
+    SDL_Thread *threads[RANDOM_STATS_MAX_THREADS];
+    struct randomizer *r = NULL;
+    struct histrand_data *d = NULL;
+    unsigned int num_threads = 0;
+    unsigned int i = 0;
+    unsigned int j = 0;
+    uint64_t chunk = 0;
+    double sum = 0.0;
+    Uint64 timestamp = 0;
+
+    if(!rs || !rs->num_pulls)
+        return -1;
+
+    // only used to look up the number of pieces and the configured weights
+    r = random_stats_randomizer_create(rs, NULL);
+    if(!r)
+        return -1;
+
+    rs->num_pieces = r->num_pieces;
+    if(r->type == HISTRAND)
+        d = (struct histrand_data *)r->data;
+
+    for(i = 0; i < rs->num_pieces; i++)
+    {
+        if(d && d->piece_weights)
+            rs->expected[i] = d->piece_weights[i];
+        else
+            rs->expected[i] = ars_piece_weights[i];
+
+        sum += rs->expected[i];
+    }
+
+    for(i = 0; i < rs->num_pieces; i++)
+        rs->expected[i] /= sum;
+
+    randomizer_destroy(r);
+
+    num_threads = rs->num_threads;
+    if(num_threads == 0)
+        num_threads = SDL_GetCPUCount();
+    if(num_threads > RANDOM_STATS_MAX_THREADS)
+        num_threads = RANDOM_STATS_MAX_THREADS;
+
+    // the per-thread histograms are too big for the stack
+    workers = (struct random_stats_worker *)calloc(num_threads, sizeof(struct random_stats_worker));
+    if(!workers)
+        return 1;
+
+    chunk = rs->num_pulls / num_threads;
+
+    for(i = 0; i < num_threads; i++)
+    {
+        workers[i].rs = rs;
+        workers[i].num_pulls = (i == num_threads - 1) ? rs->num_pulls - chunk * i : chunk;
+
+        // spread the threads' starting points evenly around the LCG cycle
+        workers[i].seed = g2_rand_rep(rs->seed, (uint32_t)(((uint64_t)(i) << 32) / num_threads));
+    }
+
+    timestamp = SDL_GetPerformanceCounter();
+
+    for(i = 0; i < num_threads; i++)
+    {
+        threads[i] = SDL_CreateThread(random_stats_thread, "random_stats", &workers[i]);
+        if(!threads[i])
+        {
+            log_err("SDL_CreateThread: %s\n", SDL_GetError());
+            random_stats_thread(&workers[i]);
+        }
+    }
+
+    for(i = 0; i < num_threads; i++)
+    {
+        if(threads[i])
+            SDL_WaitThread(threads[i], NULL);
+    }
+
+    rs->seconds = (double)(SDL_GetPerformanceCounter() - timestamp) / (double)(SDL_GetPerformanceFrequency());
+
+    memset(rs->counts, 0, sizeof(rs->counts));
+    memset(rs->droughts, 0, sizeof(rs->droughts));
+    memset(rs->max_drought, 0, sizeof(rs->max_drought));
+    rs->repeats = 0;
+    rs->history_repeats = 0;
+
+    for(i = 0; i < num_threads; i++)
+    {
+        for(j = 0; j < RANDOM_STATS_MAX_PIECES; j++)
+        {
+            rs->counts[j] += workers[i].counts[j];
+            if(workers[i].max_drought[j] > rs->max_drought[j])
+                rs->max_drought[j] = workers[i].max_drought[j];
+        }
+
+        for(j = 0; j < RANDOM_STATS_MAX_PIECES * RANDOM_STATS_DROUGHT_BINS; j++)
+            rs->droughts[j / RANDOM_STATS_DROUGHT_BINS][j % RANDOM_STATS_DROUGHT_BINS] +=
+                workers[i].droughts[j / RANDOM_STATS_DROUGHT_BINS][j % RANDOM_STATS_DROUGHT_BINS];
+
+        rs->repeats += workers[i].repeats;
+        rs->history_repeats += workers[i].history_repeats;
+    }
+
+    rs->num_threads = num_threads;
+    free(workers);
+
+    return 0;
+}
+
+void random_stats_log(struct random_stats *rs)
+{
+    unsigned int i = 0;
+    unsigned int j = 0;
+    uint64_t total = 0;
+    uint64_t droughted = 0;
+    double observed = 0.0;
+
+    if(!rs || !rs->num_pieces)
+        return;
+
+    for(i = 0; i < rs->num_pieces; i++)
+        total += rs->counts[i];
+
+    if(!total)
+        return;
+
+    log_info("Randomizer %d, difficulty %f: %llu pulls on %u threads in %f seconds (%f pulls/sec)\n", rs->randomizer_type, rs->difficulty,
+             (unsigned long long)(total), rs->num_threads, rs->seconds, rs->seconds > 0.0 ? (double)(total) / rs->seconds : 0.0);
+    log_info("Repeats: %f%% back to back, %f%% within 4 pulls\n", 100.0 * (double)(rs->repeats) / (double)(total),
+             100.0 * (double)(rs->history_repeats) / (double)(total));
+
+    for(i = 0; i < rs->num_pieces; i++)
+    {
+        // ARS randomizers hand out ARS ids, the pentomino ones hand out QRS ids
+        const char *name = get_qrspiece_name(rs->num_pieces == 7 ? ars_to_qrs_id(i) : i);
+
+        observed = (double)(rs->counts[i]) / (double)(total);
+        droughted = rs->droughts[i][RANDOM_STATS_DROUGHT_BINS - 1];
+
+        log_info("%-3s: %f%% (weighted %f%%, ratio %f), max drought %u, %llu droughts of %d+\n", name, 100.0 * observed, 100.0 * rs->expected[i],
+                 rs->expected[i] > 0.0 ? observed / rs->expected[i] : 0.0, rs->max_drought[i], (unsigned long long)(droughted),
+                 RANDOM_STATS_DROUGHT_BINS - 1);
+
+        for(j = 0; j < RANDOM_STATS_DROUGHT_BINS; j += 8)
+        {
+            log_debug("    %2u-%2u: %llu %llu %llu %llu %llu %llu %llu %llu\n", j, j + 7, (unsigned long long)(rs->droughts[i][j]),
+                      (unsigned long long)(rs->droughts[i][j + 1]), (unsigned long long)(rs->droughts[i][j + 2]),
+                      (unsigned long long)(rs->droughts[i][j + 3]), (unsigned long long)(rs->droughts[i][j + 4]),
+                      (unsigned long long)(rs->droughts[i][j + 5]), (unsigned long long)(rs->droughts[i][j + 6]),
+                      (unsigned long long)(rs->droughts[i][j + 7]));
+        }
+    }
+}
+
+int random_stats_cfg(long num_pulls)
+{
+    static const int types[] = {RANDOMIZER_NORMAL, RANDOMIZER_NIGHTMARE, RANDOMIZER_G1, RANDOMIZER_G2, RANDOMIZER_G3};
+    struct random_stats *rs = NULL;
+    unsigned int i = 0;
+
+    if(num_pulls <= 0)
+        return -1;
+
+    // too big for the stack
+    rs = (struct random_stats *)calloc(1, sizeof(struct random_stats));
+    if(!rs)
+        return 1;
+
+    for(i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+    {
+        rs->randomizer_type = types[i];
+        rs->difficulty = 0.0;
+        rs->seed = 0;
+        rs->num_pulls = num_pulls;
+        rs->num_threads = 0;
+
+        if(random_stats_run(rs) == 0)
+            random_stats_log(rs);
+    }
+
+    free(rs);
+    return 0;
+}
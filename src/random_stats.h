@@ -0,0 +1,39 @@
+#ifndef _random_stats_h
+#define _random_stats_h
+
+#include <stdint.h>
+#include "qrs.h"
+
+#define RANDOM_STATS_MAX_THREADS 16
+#define RANDOM_STATS_MAX_PIECES 25
+
+// drought lengths at or above this are counted in the last bin
+#define RANDOM_STATS_DROUGHT_BINS 64
+
+/* long-run statistics of a randomizer type, gathered by pulling from one randomizer per thread */
+struct random_stats
+{
+    int randomizer_type; // RANDOMIZER_NORMAL, RANDOMIZER_NIGHTMARE, RANDOMIZER_G1, RANDOMIZER_G2 or RANDOMIZER_G3
+    double difficulty;   // passed to histrand_set_difficulty() for the pentomino randomizers
+    uint32_t seed;       // thread i starts i/num_threads of the way around the LCG cycle from here
+    uint64_t num_pulls;
+    unsigned int num_threads;
+
+    // filled in by random_stats_run()
+    unsigned int num_pieces;
+    double seconds;
+    double expected[RANDOM_STATS_MAX_PIECES]; // share of pulls that the configured weights would give each piece
+    uint64_t counts[RANDOM_STATS_MAX_PIECES];
+    uint64_t droughts[RANDOM_STATS_MAX_PIECES][RANDOM_STATS_DROUGHT_BINS];
+    unsigned int max_drought[RANDOM_STATS_MAX_PIECES];
+    uint64_t repeats;         // same piece twice in a row
+    uint64_t history_repeats; // piece was among the previous 4
+};
+
+int random_stats_run(struct random_stats *rs);
+void random_stats_log(struct random_stats *rs);
+
+// the RANDSTATS setting: runs and logs every randomizer type for num_pulls pulls each
+int random_stats_cfg(long num_pulls);
+
+#endif
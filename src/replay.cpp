@@ -100,6 +100,8 @@ void read_replay_from_memory(struct replay *out_replay, const uint8_t *buffer, s
 {
     // Keep the same existing format
     const uint8_t *scanner = buffer;
+    unsigned int num_checkpoints = 0;
+    size_t max_checkpoints = 0;
 
     out_replay->mode = ((int *)scanner)[0];
     scanner += sizeof(int);
@@ -129,6 +131,24 @@ void read_replay_from_memory(struct replay *out_replay, const uint8_t *buffer, s
     scanner += sizeof(int);
 
     memcpy(&out_replay->pinputs[0], scanner, out_replay->len * sizeof(struct packed_input));
+    scanner += out_replay->len * sizeof(struct packed_input);
+
+    // checkpoints trail the inputs so older replays stay readable
+    out_replay->num_checkpoints = 0;
+    if((size_t)(scanner - buffer) + sizeof(int) <= bufferLength)
+    {
+        num_checkpoints = ((int *)scanner)[0];
+        scanner += sizeof(int);
+
+        max_checkpoints = (bufferLength - (scanner - buffer)) / sizeof(struct replay_checkpoint);
+        if(num_checkpoints > max_checkpoints)
+            num_checkpoints = max_checkpoints;
+        if(num_checkpoints > MAX_REPLAY_CHECKPOINTS)
+            num_checkpoints = MAX_REPLAY_CHECKPOINTS;
+
+        memcpy(&out_replay->checkpoints[0], scanner, num_checkpoints * sizeof(struct replay_checkpoint));
+        out_replay->num_checkpoints = num_checkpoints;
+    }
 }
 
 uint8_t *generate_raw_replay(struct replay *r, size_t *out_replayLength)
@@ -167,6 +187,12 @@ uint8_t *generate_raw_replay(struct replay *r, size_t *out_replayLength)
     memcpy(buffer + bufferOffset, &r->pinputs, sizeof(struct packed_input) * r->len);
     bufferOffset += sizeof(struct packed_input) * r->len;
 
+    memcpy(buffer + bufferOffset, &r->num_checkpoints, sizeof(int));
+    bufferOffset += sizeof(int);
+
+    memcpy(buffer + bufferOffset, &r->checkpoints, sizeof(struct replay_checkpoint) * r->num_checkpoints);
+    bufferOffset += sizeof(struct replay_checkpoint) * r->num_checkpoints;
+
     *out_replayLength = bufferOffset;
 
     return buffer;
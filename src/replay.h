@@ -5,6 +5,9 @@
 
 #define MAX_KEYFLAGS 72000 // 20 minutes of inputs (@ 60 fps)
 
+#define REPLAY_CHECKPOINT_INTERVAL 60 // frames between state hash checkpoints
+#define MAX_REPLAY_CHECKPOINTS (MAX_KEYFLAGS / REPLAY_CHECKPOINT_INTERVAL)
+
 #include <time.h>
 #include <stdint.h>
 
@@ -18,6 +21,13 @@ struct packed_input
 struct packed_input pack_input(struct keyflags *k);
 void unpack_input(struct packed_input p, struct keyflags *out_keys);
 
+// qs_state_hash() before the input of a frame was applied
+struct replay_checkpoint
+{
+    uint32_t frame;
+    uint32_t hash;
+};
+
 struct replay
 {
     unsigned int len;
@@ -36,6 +46,10 @@ struct replay
     int index;
 
     struct packed_input pinputs[MAX_KEYFLAGS];
+
+    // optional; replays saved before these existed load with none
+    unsigned int num_checkpoints;
+    struct replay_checkpoint checkpoints[MAX_REPLAY_CHECKPOINTS];
 };
 
 void get_replay_descriptor(struct replay *r, char *buffer, size_t bufferLength);
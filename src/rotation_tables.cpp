@@ -1,9 +1,11 @@
 #include "rotation_tables.h"
+#include "piecedef.h"
+#include "qrs.h"
 
 #define O 1
 #define _ 0
 
-int qrspent_yx_rotation_tables[18][4][5][5] =
+static constexpr int qrspent_yx_rotation_tables[18][4][5][5] =
 {
     { // I
         { // FLAT
@@ -618,7 +620,7 @@ int qrspent_yx_rotation_tables[18][4][5][5] =
     }
 };
 
-int qrstet_yx_rotation_tables[7][4][4][4] =
+static constexpr int qrstet_yx_rotation_tables[7][4][4][4] =
 {
     { // I4
         { // FLAT
@@ -833,3 +835,218 @@ int qrstet_yx_rotation_tables[7][4][4][4] =
 
 #undef _
 #undef O
+
+// TGM-style kick behaviour of each piece, as the pool used to set it up at runtime
+
+static constexpr unsigned int default_kick_flags(int id)
+{
+    switch(id)
+    {
+        case QRS_I:
+        case QRS_J:
+        case QRS_L:
+        case QRS_N:
+        case QRS_G:
+        case QRS_Ya:
+        case QRS_Yb:
+            return 0;
+        case QRS_T:
+            return PDFLATFLOORKICKS;
+        case QRS_I4:
+            return PDNOWKICK;
+        case QRS_T4:
+            return PDFLATFLOORKICKS | PDONECELLFLOORKICKS | PDPREFERWKICK | PDAIRBORNEFKICKS;
+        default:
+            return PDNOFKICK;
+    }
+}
+
+// vertical pieces don't kick when the first collision is in their center column
+
+static constexpr uint8_t wallkick_block(int id, int o)
+{
+    bool vertical = (o == CW || o == CCW);
+
+    switch(id)
+    {
+        case QRS_I:
+        case QRS_I4:
+            return vertical ? 0x1f : 0;
+        case QRS_J:
+            return vertical ? 1 << 2 : 0;
+        case QRS_L:
+        case QRS_L4:
+        case QRS_J4:
+        case QRS_T4:
+            return vertical ? 1 << 1 : 0;
+        case QRS_N:
+        case QRS_G:
+        case QRS_Ya:
+        case QRS_Yb:
+            if(o == CW)
+                return 1 << 2;
+            if(o == CCW)
+                return 1 << 1;
+            return 0;
+        default:
+            return 0;
+    }
+}
+
+static constexpr bool double_wallkick(int id, int o)
+{
+    switch(id)
+    {
+        case QRS_I:
+        case QRS_I4:
+            return true;
+        case QRS_J:
+        case QRS_L:
+        case QRS_Ya:
+        case QRS_Yb:
+            return o == FLAT || o == FLIP;
+        default:
+            return false;
+    }
+}
+
+template <int N>
+static constexpr struct qrs_shape_rot make_rot(const int (&t)[N][N], int id, int o)
+{
+    struct qrs_shape_rot r {};
+    int x = 0;
+    int y = 0;
+
+    r.min_x = N;
+    r.max_x = -1;
+    r.min_y = N;
+    r.max_y = -1;
+
+    for(x = 0; x < QRS_SHAPE_MAX_W; x++)
+    {
+        r.bottom[x] = -1;
+        r.left[x] = -1;
+        r.right[x] = -1;
+    }
+
+    for(y = 0; y < N; y++)
+    {
+        for(x = 0; x < N; x++)
+        {
+            if(!t[y][x])
+                continue;
+
+            r.mask |= 1u << (y * N + x);
+
+            if(x < r.min_x)
+                r.min_x = x;
+            if(x > r.max_x)
+                r.max_x = x;
+            if(y < r.min_y)
+                r.min_y = y;
+            r.max_y = y;
+
+            r.bottom[x] = y;
+            if(r.left[y] < 0)
+                r.left[y] = x;
+            r.right[y] = x;
+        }
+    }
+
+    r.wallkick_block = wallkick_block(id, o);
+    r.double_wallkick = double_wallkick(id, o);
+
+    return r;
+}
+
+static constexpr int count_bits(uint32_t m)
+{
+    int n = 0;
+
+    for(; m; m &= m - 1)
+        n++;
+
+    return n;
+}
+
+static constexpr struct qrs_shapeset make_shapes()
+{
+    struct qrs_shapeset s {};
+    int i = 0;
+    int j = 0;
+
+    for(i = 0; i < 25; i++)
+    {
+        s.pieces[i].w = i < 18 ? 5 : 4;
+        s.pieces[i].flags = default_kick_flags(i);
+
+        for(j = 0; j < 4; j++)
+        {
+            if(i < 18)
+                s.pieces[i].rot[j] = make_rot(qrspent_yx_rotation_tables[i][j], i, j);
+            else
+                s.pieces[i].rot[j] = make_rot(qrstet_yx_rotation_tables[i - 18][j], i, j);
+        }
+
+        s.pieces[i].num_cells = count_bits(s.pieces[i].rot[0].mask);
+    }
+
+    return s;
+}
+
+constexpr struct qrs_shapeset qrs_shapes = make_shapes();
+
+static constexpr bool shapes_are_consistent()
+{
+    int i = 0;
+    int j = 0;
+    int k = 0;
+
+    for(i = 0; i < 25; i++)
+    {
+        const struct qrs_shape &s = qrs_shapes.pieces[i];
+
+        if(s.num_cells != (i < 18 ? 5 : 4))
+            return false;
+
+        for(j = 0; j < 4; j++)
+        {
+            const struct qrs_shape_rot &r = s.rot[j];
+
+            if(count_bits(r.mask) != s.num_cells)
+                return false;
+
+            for(k = 0; k < s.w; k++)
+            {
+                if(r.bottom[k] >= 0 && (r.bottom[k] > r.max_y || !(r.mask & (1u << (r.bottom[k] * s.w + k)))))
+                    return false;
+
+                if(r.left[k] >= 0 && (r.left[k] < r.min_x || !(r.mask & (1u << (k * s.w + r.left[k])))))
+                    return false;
+
+                if(r.right[k] >= 0 && (r.right[k] > r.max_x || !(r.mask & (1u << (k * s.w + r.right[k])))))
+                    return false;
+
+                // pieces are connected, so no row inside the bounding box is empty
+                if(k >= r.min_y && k <= r.max_y && r.left[k] < 0)
+                    return false;
+            }
+        }
+    }
+
+    return true;
+}
+
+static_assert(shapes_are_consistent(), "rotation tables: inconsistent derived shape data");
+
+static_assert(qrs_shapes.pieces[QRS_I].rot[FLAT].mask == 0x1fu << 10, "rotation tables: I should lie flat on row 2");
+static_assert(qrs_shapes.pieces[QRS_I].rot[CW].bottom[2] == 4, "rotation tables: vertical I should fill column 2");
+static_assert(qrs_shapes.pieces[QRS_I4].rot[FLAT].mask == 0xfu << 4, "rotation tables: I4 should lie flat on row 1");
+
+static_assert(qrs_shapes.pieces[QRS_J].rot[CW].wallkick_block == 1 << 2, "rotation tables: wallkick exceptions");
+static_assert(qrs_shapes.pieces[QRS_N].rot[CCW].wallkick_block == 1 << 1, "rotation tables: wallkick exceptions");
+static_assert(qrs_shapes.pieces[QRS_T4].rot[FLAT].wallkick_block == 0, "rotation tables: wallkick exceptions");
+static_assert(!qrs_shapes.pieces[QRS_L].rot[CW].double_wallkick, "rotation tables: wallkick exceptions");
+
+static_assert(qrs_shapes.pieces[QRS_I4].flags == PDNOWKICK, "rotation tables: floorkick flags");
+static_assert(qrs_shapes.pieces[QRS_X].flags == PDNOFKICK, "rotation tables: floorkick flags");
@@ -1,7 +1,43 @@
 #ifndef _rotation_tables_h
 #define _rotation_tables_h
 
-extern int qrspent_yx_rotation_tables[18][4][5][5];
-extern int qrstet_yx_rotation_tables[7][4][4][4];
+#include <stdint.h>
+
+#define QRS_SHAPE_MAX_W 5
+
+// everything here is generated at compile time from the yx rotation tables in rotation_tables.cpp
+
+struct qrs_shape_rot
+{
+    uint32_t mask;    // bit (y * w + x) set for each filled cell, i.e. the same numbering as grid positions
+
+    int8_t min_x;    // bounding box of the filled cells
+    int8_t max_x;
+    int8_t min_y;
+    int8_t max_y;
+
+    int8_t bottom[QRS_SHAPE_MAX_W];    // lowest filled row of each column, -1 for empty columns
+    int8_t left[QRS_SHAPE_MAX_W];      // leftmost filled column of each row, -1 for empty rows
+    int8_t right[QRS_SHAPE_MAX_W];     // rightmost filled column of each row, -1 for empty rows
+
+    uint8_t wallkick_block;    // bit x set: a collision first found in column x forbids wallkicks
+    bool double_wallkick;      // may try 2-cell kicks once both 1-cell kicks failed
+};
+
+struct qrs_shape
+{
+    int w;    // rotation tables are w * w
+    int num_cells;
+    unsigned int flags;    // default PD* kick flags of the piece
+
+    struct qrs_shape_rot rot[4];
+};
+
+struct qrs_shapeset
+{
+    struct qrs_shape pieces[25];
+};
+
+extern const struct qrs_shapeset qrs_shapes;
 
 #endif
@@ -0,0 +1,271 @@
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+
+#include "debug.h"
+#include "game_qs.h"
+#include "random.h"
+#include "seed_scan.h"
+
+struct seed_scan_worker
+{
+    struct seed_scan *scan;
+    SDL_atomic_t *found;
+
+    uint32_t first_seed;
+    uint64_t num_seeds;
+
+    uint32_t seed;
+    uint32_t *results;
+    unsigned int num_results;
+};
+
+static void seed_scan_reset(struct seed_scan *s, struct randomizer *r)
+{
+    struct histrand_data *hd = NULL;
+    struct g3rand_data *gd = NULL;
+    int i = 0;
+
+    if(r->type == G3RAND)
+    {
+        gd = (struct g3rand_data *)r->data;
+
+        for(i = 0; i < 35; i++)
+            gd->bag[i] = i / 5;
+
+        for(i = 0; i < 7; i++)
+            gd->histogram[i] = 0;
+
+        gd->history[0] = ARS_S;
+        gd->history[1] = ARS_S;
+        gd->history[2] = ARS_Z;
+        gd->history[3] = PIECE_ID_INVALID;
+
+        return;
+    }
+
+    hd = (struct histrand_data *)r->data;
+
+    if(s->history)
+    {
+        for(i = 0; i < 4; i++)
+            hd->history[i] = s->history[i];
+
+        return;
+    }
+
+    if(s->randomizer_type == RANDOMIZER_G1)
+    {
+        hd->history[0] = ARS_Z;
+        hd->history[1] = ARS_Z;
+        hd->history[2] = ARS_Z;
+    }
+    else
+    {
+        hd->history[0] = ARS_S;
+        hd->history[1] = ARS_S;
+        hd->history[2] = ARS_Z;
+    }
+
+    hd->history[3] = PIECE_ID_INVALID;
+}
+
+int seed_matches_sequence(struct seed_scan *s, struct randomizer *r, uint32_t seed)
+{
+    piece_id *history = NULL;
+    unsigned int i = 0;
+
+    if(r->type == G3RAND)
+        history = ((struct g3rand_data *)r->data)->history;
+    else
+        history = ((struct histrand_data *)r->data)->history;
+
+    seed_scan_reset(s, r);
+    *r->seedp = seed;
+
+    if(!s->history)
+    {
+        // same steps as g1/g2/g3_randomizer_init(), bailing out as soon as a piece differs
+        history[3] = g123_get_init_piece(r->seedp);
+        if(history[3] != s->sequence[0])
+            return 0;
+
+        i = 1;
+    }
+
+    // each pull pushes the newly generated piece onto the end of the history
+    for(; i < s->seq_len; i++)
+    {
+        r->pull(r);
+        if(history[3] != s->sequence[i])
+            return 0;
+    }
+
+    return 1;
+}
+
+static int seed_scan_thread(void *data)
+{
+    struct seed_scan_worker *w = (struct seed_scan_worker *)data;
+    struct seed_scan *s = w->scan;
+    struct randomizer *r = thread_randomizer_create(s->randomizer_type, &w->seed);
+    uint64_t n = 0;
+    uint32_t seed = w->first_seed;
+
+    for(n = 0; n < w->num_seeds; n++, seed++)
+    {
+        if(seed_matches_sequence(s, r, seed))
+        {
+            if(SDL_AtomicAdd(w->found, 1) >= (int)(s->max_results))
+                break;
+
+            w->results[w->num_results] = seed;
+            w->num_results++;
+        }
+
+        // cheap check so that every thread stops soon after the result buffer fills up
+        if((n & 0xffff) == 0 && SDL_AtomicGet(w->found) >= (int)(s->max_results))
+            break;
+    }
+
+    randomizer_destroy(r);
+
+    return 0;
+}
+
+int seed_scan_run(struct seed_scan *s)
+{
+    if(!s || !s->sequence || !s->seq_len || !s->results || !s->max_results)
+        return -1;
+
+    if(s->randomizer_type != RANDOMIZER_G1 && s->randomizer_type != RANDOMIZER_G2 && s->randomizer_type != RANDOMIZER_G3)
+        return -1;
+
+    // the G3 bag can't be recovered from a 4-piece history
+    if(s->history && s->randomizer_type == RANDOMIZER_G3)
+        return -1;
+
+    if(s->num_seeds == 0 || s->num_seeds > 0x100000000ull)
+        return -1;
+
+    struct seed_scan_worker workers[SEED_SCAN_MAX_THREADS];
+    SDL_Thread *threads[SEED_SCAN_MAX_THREADS];
+    SDL_atomic_t found;
+    unsigned int num_threads = s->num_threads;
+    unsigned int i = 0;
+    unsigned int j = 0;
+    uint64_t chunk = 0;
+    uint64_t offset = 0;
+    Uint64 timestamp = SDL_GetPerformanceCounter();
+
+    if(num_threads == 0)
+        num_threads = SDL_GetCPUCount();
+    if(num_threads > SEED_SCAN_MAX_THREADS)
+        num_threads = SEED_SCAN_MAX_THREADS;
+
+    SDL_AtomicSet(&found, 0);
+    s->num_results = 0;
+    chunk = s->num_seeds / num_threads;
+
+    for(i = 0; i < num_threads; i++)
+    {
+        workers[i].scan = s;
+        workers[i].found = &found;
+        workers[i].first_seed = (uint32_t)(s->first_seed + offset);
+        workers[i].num_seeds = (i == num_threads - 1) ? s->num_seeds - offset : chunk;
+        workers[i].seed = 0;
+        workers[i].results = (uint32_t *)malloc(s->max_results * sizeof(uint32_t));
+        workers[i].num_results = 0;
+
+        offset += chunk;
+    }
+
+    for(i = 0; i < num_threads; i++)
+    {
+        threads[i] = SDL_CreateThread(seed_scan_thread, "seed_scan", &workers[i]);
+        if(!threads[i])
+        {
+            // fall back to scanning this chunk on the calling thread
+            log_err("SDL_CreateThread: %s\n", SDL_GetError());
+            seed_scan_thread(&workers[i]);
+        }
+    }
+
+    // threads were given ascending seed ranges, so the merged results come out in seed order
+    for(i = 0; i < num_threads; i++)
+    {
+        if(threads[i])
+            SDL_WaitThread(threads[i], NULL);
+
+        for(j = 0; j < workers[i].num_results && s->num_results < s->max_results; j++)
+        {
+            s->results[s->num_results] = workers[i].results[j];
+            s->num_results++;
+        }
+
+        free(workers[i].results);
+    }
+
+    timestamp = SDL_GetPerformanceCounter() - timestamp;
+    log_debug("Seed scan: %u matches in %llu seeds, %u threads, %f seconds\n", s->num_results, (unsigned long long)(s->num_seeds), num_threads,
+              (double)(timestamp) / (double)(SDL_GetPerformanceFrequency()));
+
+    return 0;
+}
+
+int seed_scan_cfg(const char *spec)
+{
+    if(!spec)
+        return -1;
+
+    static const char ars_letters[] = "IZSJLOT";
+    struct seed_scan s;
+    piece_id sequence[SEED_SCAN_MAX_SEQ];
+    uint32_t results[SEED_SCAN_MAX_RESULTS];
+    const char *p = NULL;
+    const char *letter = NULL;
+    unsigned int i = 0;
+
+    if(spec[0] != 'G' || spec[1] < '1' || spec[1] > '3' || spec[2] != ':')
+    {
+        log_err("SEEDSCAN %s: expected G1:, G2: or G3: followed by pieces\n", spec);
+        return -1;
+    }
+
+    s.randomizer_type = RANDOMIZER_G1 + (spec[1] - '1');
+    s.history = NULL;
+    s.sequence = sequence;
+    s.seq_len = 0;
+
+    for(p = spec + 3; *p; p++)
+    {
+        letter = strchr(ars_letters, *p);
+        if(!letter || s.seq_len == SEED_SCAN_MAX_SEQ)
+        {
+            log_err("SEEDSCAN %s: expected at most %d of the letters %s\n", spec, SEED_SCAN_MAX_SEQ, ars_letters);
+            return -1;
+        }
+
+        sequence[s.seq_len++] = (piece_id)(letter - ars_letters);
+    }
+
+    s.first_seed = 0;
+    s.num_seeds = 0x100000000ull;
+    s.num_threads = 0;
+    s.results = results;
+    s.max_results = SEED_SCAN_MAX_RESULTS;
+    s.num_results = 0;
+
+    log_info("Scanning all seeds for %s\n", spec);
+
+    if(seed_scan_run(&s))
+        return 1;
+
+    for(i = 0; i < s.num_results; i++)
+        log_info("SEEDSCAN %s: 0x%08x\n", spec, results[i]);
+
+    log_info("SEEDSCAN %s: %u seeds%s\n", spec, s.num_results, s.num_results == s.max_results ? " (stopped at the limit)" : "");
+    return 0;
+}
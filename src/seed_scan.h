@@ -0,0 +1,43 @@
+#ifndef _seed_scan_h
+#define _seed_scan_h
+
+#include <stdint.h>
+#include "qrs.h"
+#include "random.h"
+
+#define SEED_SCAN_MAX_THREADS 16
+
+/* brute-force search of the 32-bit seed space for the seeds that produce a given
+   sequence of ARS pieces under the G1/G2/G3 randomizers */
+struct seed_scan
+{
+    int randomizer_type; // RANDOMIZER_G1, RANDOMIZER_G2 or RANDOMIZER_G3
+
+    // if NULL, sequence[0] is the first piece of a game (as given by g123_get_init_piece)
+    // otherwise, the 4 pieces in the randomizer's history just before sequence[0] is generated (G1/G2 only)
+    piece_id *history;
+
+    piece_id *sequence;
+    unsigned int seq_len;
+
+    uint32_t first_seed;
+    uint64_t num_seeds; // 0x100000000 for the whole seed space
+    unsigned int num_threads;
+
+    // filled in by seed_scan_run(); a seed here is the seed right before the first piece of the sequence is read
+    uint32_t *results;
+    unsigned int max_results;
+    unsigned int num_results;
+};
+
+int seed_scan_run(struct seed_scan *s);
+int seed_matches_sequence(struct seed_scan *s, struct randomizer *r, uint32_t seed);
+
+#define SEED_SCAN_MAX_SEQ 32
+#define SEED_SCAN_MAX_RESULTS 64
+
+/* the SEEDSCAN setting: "G1:", "G2:" or "G3:" followed by the ARS pieces a game opened with, as
+   letters (IZSJLOT). scans the whole seed space on every CPU and logs the seeds that match */
+int seed_scan_cfg(const char *spec);
+
+#endif
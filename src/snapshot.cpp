@@ -0,0 +1,209 @@
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <SDL2/SDL.h>
+
+#include "core.h"
+#include "debug.h"
+#include "qrs.h"
+#include "random.h"
+#include "replay.h"
+#include "snapshot.h"
+#include "state_hash.h"
+#include "timer.h"
+
+static_assert(sizeof(struct qs_snapshot) <= QS_SNAPSHOT_BUDGET, "struct qs_snapshot is over its size budget");
+
+static piece_id snapshot_piece_id(const piecedef *pd)
+{
+    return pd ? pd->qrs_id : PIECE_ID_INVALID;
+}
+
+static const piecedef *snapshot_piece(qrsdata *q, piece_id id)
+{
+    return id == PIECE_ID_INVALID ? NULL : qrspiece_get(q->piecepool, id);
+}
+
+int qs_snapshot_save(game_t *g, struct qs_snapshot *s)
+{
+    if(!g || !g->data || !s)
+        return -1;
+
+    qrsdata *q = (qrsdata *)g->data;
+    struct randomizer *r = q->randomizer;
+    struct histrand_data *hd = NULL;
+    int i = 0;
+
+    if(g->field->w != QRS_FIELD_W || g->field->h != QRS_FIELD_H)
+        return 1;
+
+    s->size = sizeof(struct qs_snapshot);
+    s->hash = qs_state_hash(g);
+
+    s->frame_counter = g->frame_counter;
+    s->time = q->timer->time;
+
+    s->q = *q;
+    s->p1 = *q->p1;
+    s->counters = *q->p1counters;
+
+    s->p1_def = snapshot_piece_id(q->p1->def);
+    for(i = 0; i < 3; i++)
+        s->previews[i] = snapshot_piece_id(q->previews[i]);
+    s->hold = snapshot_piece_id(q->hold);
+
+    s->seed = (r && r->seedp) ? *r->seedp : 0;
+
+    if(r && r->type == HISTRAND)
+    {
+        hd = (struct histrand_data *)r->data;
+        if(hd->hist_len > QS_SNAPSHOT_MAX_HISTORY || r->num_pieces > QS_SNAPSHOT_MAX_PIECES)
+            return 1;
+
+        s->rand_rerolls = hd->rerolls;
+        s->rand_difficulty = hd->difficulty;
+        if(hd->history)
+            memcpy(s->rand_history, hd->history, hd->hist_len * sizeof(piece_id));
+        if(hd->drought_times)
+            memcpy(s->rand_drought_times, hd->drought_times, r->num_pieces * sizeof(unsigned int));
+    }
+    else if(r && r->type == G3RAND)
+        s->g3 = *(struct g3rand_data *)r->data;
+
+    s->field_row_offset = g->field->row_offset;
+    for(i = 0; i < QRS_FIELD_W; i++)
+        memcpy(s->field[i], g->field->grid[i], QRS_FIELD_H * sizeof(int));
+
+    s->prev_keys = g->origin->prev_keys;
+    s->hold_dir = g->origin->hold_dir;
+    s->hold_time = g->origin->hold_time;
+
+    s->replay_len = q->replay ? q->replay->len : 0;
+    s->replay_checkpoints = q->replay ? q->replay->num_checkpoints : 0;
+
+    return 0;
+}
+
+int qs_snapshot_restore(game_t *g, const struct qs_snapshot *s)
+{
+    if(!g || !g->data || !s)
+        return -1;
+
+    qrsdata *q = (qrsdata *)g->data;
+    qrsdata live = *q;
+    struct randomizer *r = q->randomizer;
+    struct histrand_data *hd = NULL;
+    int i = 0;
+
+    if(s->size != sizeof(struct qs_snapshot) || s->q.mode_type != q->mode_type ||
+       s->q.randomizer_type != q->randomizer_type || s->q.field_w != q->field_w ||
+       g->field->w != QRS_FIELD_W || g->field->h != QRS_FIELD_H)
+    {
+        log_err("Snapshot does not belong to this game\n");
+        return 1;
+    }
+
+    *q = s->q;
+
+    q->piecepool = live.piecepool;
+    q->randomizer = live.randomizer;
+    q->pracdata = live.pracdata;
+    q->replay = live.replay;
+    q->garbage = live.garbage;
+    q->piece_seq = live.piece_seq;
+    q->timer = live.timer;
+    q->p1 = live.p1;
+    q->p1counters = live.p1counters;
+    q->recording = live.recording;
+    q->playback = live.playback;
+
+    for(i = 0; i < 3; i++)
+        q->previews[i] = snapshot_piece(q, s->previews[i]);
+    q->hold = snapshot_piece(q, s->hold);
+
+    *q->p1 = s->p1;
+    q->p1->def = snapshot_piece(q, s->p1_def);
+    *q->p1counters = s->counters;
+
+    q->timer->time = s->time;
+    g->frame_counter = s->frame_counter;
+
+    if(r && r->seedp)
+        *r->seedp = s->seed;
+
+    if(r && r->type == HISTRAND)
+    {
+        hd = (struct histrand_data *)r->data;
+
+        hd->rerolls = s->rand_rerolls;
+        hd->difficulty = s->rand_difficulty;
+        if(hd->history)
+            memcpy(hd->history, s->rand_history, hd->hist_len * sizeof(piece_id));
+        if(hd->drought_times)
+            memcpy(hd->drought_times, s->rand_drought_times, r->num_pieces * sizeof(unsigned int));
+    }
+    else if(r && r->type == G3RAND)
+        *(struct g3rand_data *)r->data = s->g3;
+
+    g->field->row_offset = s->field_row_offset;
+    for(i = 0; i < QRS_FIELD_W; i++)
+        memcpy(g->field->grid[i], s->field[i], QRS_FIELD_H * sizeof(int));
+
+    g->origin->prev_keys = s->prev_keys;
+    g->origin->hold_dir = s->hold_dir;
+    g->origin->hold_time = s->hold_time;
+
+    // rewinding a recording drops the inputs after the snapshot
+    if(q->recording && q->replay && s->replay_len <= q->replay->len)
+    {
+        q->replay->len = s->replay_len;
+        q->replay->num_checkpoints = s->replay_checkpoints;
+    }
+
+    q->state_hash = qs_state_hash(g);
+    if(q->state_hash != s->hash)
+    {
+        log_err("Snapshot restore mismatch (state hash %08x, expected %08x)\n", q->state_hash, s->hash);
+        return 1;
+    }
+
+    return 0;
+}
+
+int qs_snapshot_benchmark(game_t *g, unsigned int iterations)
+{
+    if(!g || !g->data || !iterations)
+        return -1;
+
+    struct qs_snapshot *s = (struct qs_snapshot *)malloc(sizeof(struct qs_snapshot));
+    Uint64 timestamp = 0;
+    double seconds = 0.0;
+    unsigned int i = 0;
+    int rc = 0;
+
+    if(!s)
+        return 1;
+
+    rc = qs_snapshot_save(g, s);
+
+    timestamp = SDL_GetPerformanceCounter();
+
+    for(i = 0; i < iterations && !rc; i++)
+    {
+        rc = qs_snapshot_save(g, s);
+        if(!rc)
+            rc = qs_snapshot_restore(g, s);
+    }
+
+    seconds = (double)(SDL_GetPerformanceCounter() - timestamp) / (double)(SDL_GetPerformanceFrequency());
+
+    if(!rc)
+    {
+        log_info("Snapshot: %u bytes (budget %d), %u save/restore pairs in %f seconds (%f us per pair)\n",
+                 (unsigned int)sizeof(struct qs_snapshot), QS_SNAPSHOT_BUDGET, iterations, seconds,
+                 seconds * 1000000.0 / (double)iterations);
+    }
+
+    free(s);
+    return rc;
+}
@@ -0,0 +1,69 @@
+#ifndef _snapshot_h
+#define _snapshot_h
+
+#include <stdint.h>
+#include "core.h"
+#include "qrs.h"
+#include "random.h"
+
+// a snapshot has to stay small enough to keep one per second of a replay around
+#define QS_SNAPSHOT_BUDGET 4096
+
+#define QS_SNAPSHOT_BENCH_FRAME 3600    // SNAPBENCH runs this far into a game, so there's a stack and history to copy
+
+#define QS_SNAPSHOT_MAX_HISTORY 8
+#define QS_SNAPSHOT_MAX_PIECES 25
+
+/* everything a running qs game needs to carry on from a given frame, in one flat block: save and restore
+   are a handful of memcpy()s and never allocate, so callers can keep as many as they like (replay keyframes,
+   practice rewind, suspend/resume)
+
+   a snapshot only restores into the game it was taken from, or one set up the same way (same mode,
+   randomizer and field width): the piece pool, randomizer, garbage sequence and speed curves are not
+   copied, only referred to. pracdata is the practice editor's and is left alone */
+struct qs_snapshot
+{
+    uint32_t size;    // sizeof(struct qs_snapshot), so snapshots from another build are refused
+    uint32_t hash;    // qs_state_hash() when taken; checked again after restoring
+
+    unsigned long frame_counter;
+    unsigned long time;
+
+    // pointer members are not restored; the live game's are kept
+    qrsdata q;
+    qrs_player p1;
+    qrs_counters counters;
+
+    // pool entries by qrs_id, PIECE_ID_INVALID for none
+    piece_id p1_def;
+    piece_id previews[3];
+    piece_id hold;
+
+    uint32_t seed;
+    unsigned int rand_rerolls;
+    double rand_difficulty;
+    piece_id rand_history[QS_SNAPSHOT_MAX_HISTORY];
+    unsigned int rand_drought_times[QS_SNAPSHOT_MAX_PIECES];
+    struct g3rand_data g3;
+
+    // g->field in storage order, so the ring offset comes along as-is
+    int field_row_offset;
+    int field[QRS_FIELD_W][QRS_FIELD_H];
+
+    // DAS carries over between frames
+    struct keyflags prev_keys;
+    das_direction hold_dir;
+    int hold_time;
+
+    // a recording is cut back to this when restoring into it
+    unsigned int replay_len;
+    unsigned int replay_checkpoints;
+};
+
+int qs_snapshot_save(game_t *g, struct qs_snapshot *s);
+int qs_snapshot_restore(game_t *g, const struct qs_snapshot *s);
+
+// times iterations save/restore pairs on g and logs the result
+int qs_snapshot_benchmark(game_t *g, unsigned int iterations);
+
+#endif
@@ -0,0 +1,166 @@
+#include <stdint.h>
+#include <string.h>
+
+#include "core.h"
+#include "qrs.h"
+#include "random.h"
+#include "state_hash.h"
+#include "timer.h"
+
+static uint32_t hash_mix(uint32_t h, uint32_t v)
+{
+    h ^= v;
+    h *= 0x01000193u;
+    h ^= h >> 15;
+
+    return h;
+}
+
+static uint32_t hash_mix_double(uint32_t h, double d)
+{
+    uint64_t bits = 0;
+
+    memcpy(&bits, &d, sizeof(double));
+
+    h = hash_mix(h, (uint32_t)bits);
+    return hash_mix(h, (uint32_t)(bits >> 32));
+}
+
+static uint32_t hash_mix_piece(uint32_t h, const piecedef *pd, unsigned int flags)
+{
+    h = hash_mix(h, pd ? (uint32_t)pd->qrs_id : 0xffffffffu);
+    return hash_mix(h, flags);
+}
+
+static uint32_t hash_randomizer(uint32_t h, struct randomizer *r)
+{
+    struct histrand_data *hd = NULL;
+    struct g3rand_data *g3 = NULL;
+    unsigned int i = 0;
+
+    if(!r)
+        return hash_mix(h, 0);
+
+    h = hash_mix(h, r->type);
+    h = hash_mix(h, r->seedp ? *r->seedp : 0);
+
+    if(!r->data)
+        return h;
+
+    switch(r->type)
+    {
+        case HISTRAND:
+            hd = (struct histrand_data *)r->data;
+
+            h = hash_mix(h, hd->rerolls);
+            h = hash_mix_double(h, hd->difficulty);
+
+            for(i = 0; hd->history && i < hd->hist_len; i++)
+                h = hash_mix(h, hd->history[i]);
+
+            for(i = 0; hd->drought_times && i < r->num_pieces; i++)
+                h = hash_mix(h, hd->drought_times[i]);
+            break;
+
+        case G3RAND:
+            g3 = (struct g3rand_data *)r->data;
+
+            for(i = 0; i < 4; i++)
+                h = hash_mix(h, g3->history[i]);
+            for(i = 0; i < 35; i++)
+                h = hash_mix(h, g3->bag[i]);
+            for(i = 0; i < 7; i++)
+                h = hash_mix(h, g3->histogram[i]);
+            break;
+
+        default:
+            break;
+    }
+
+    return h;
+}
+
+uint32_t qs_state_hash(game_t *g)
+{
+    if(!g || !g->data)
+        return 0;
+
+    qrsdata *q = (qrsdata *)g->data;
+    qrs_player *p = q->p1;
+    qrs_counters *c = q->p1counters;
+    uint32_t h = 0x811c9dc5u;
+    int i = 0;
+
+    h = hash_mix(h, g->frame_counter);
+    h = hash_mix(h, q->timer ? q->timer->time : 0);
+
+    if(p)
+    {
+        h = hash_mix_piece(h, p->def, p->def_flags);
+        h = hash_mix(h, p->state);
+        h = hash_mix(h, p->x);
+        h = hash_mix(h, p->y);
+        h = hash_mix(h, p->orient);
+    }
+
+    if(c)
+    {
+        h = hash_mix(h, c->init);
+        h = hash_mix(h, c->lock);
+        h = hash_mix(h, c->are);
+        h = hash_mix(h, c->lineare);
+        h = hash_mix(h, c->lineclear);
+        h = hash_mix(h, c->floorkicks);
+        h = hash_mix(h, c->hold_flash);
+    }
+
+    for(i = 0; i < 3; i++)
+        h = hash_mix_piece(h, q->previews[i], q->preview_flags[i]);
+    h = hash_mix_piece(h, q->hold, q->hold_flags);
+
+    h = hash_mix(h, q->field_w);
+    for(i = 0; i < QRS_FIELD_H; i++)
+        h = hash_mix(h, q->field_counts.row_hash[i]);
+
+    h = hash_randomizer(h, q->randomizer);
+
+    h = hash_mix(h, q->cur_piece_qrs_id);
+    h = hash_mix(h, q->state_flags);
+    h = hash_mix(h, q->piece_seq_index);
+    h = hash_mix(h, q->garbage_row_index);
+    h = hash_mix(h, q->garbage_counter);
+    h = hash_mix(h, q->garbage_delay);
+    h = hash_mix(h, q->stack_anim_counter);
+    h = hash_mix(h, q->credit_roll_counter);
+    h = hash_mix(h, q->credit_roll_lineclears);
+
+    h = hash_mix(h, q->level);
+    h = hash_mix(h, q->section);
+    h = hash_mix_double(h, q->rank);
+    h = hash_mix(h, q->score);
+    h = hash_mix(h, q->soft_drop_counter);
+    h = hash_mix(h, q->sonic_drop_height);
+    h = hash_mix(h, q->active_piece_time);
+    h = hash_mix(h, q->placement_speed);
+    h = hash_mix(h, q->levelstop_time);
+
+    h = hash_mix(h, q->grade);
+    h = hash_mix(h, q->internal_grade);
+    h = hash_mix(h, q->grade_points);
+    h = hash_mix(h, q->grade_decay_counter);
+    h = hash_mix(h, q->mroll_unlocked);
+
+    h = hash_mix(h, q->lock_on_rotate);
+    h = hash_mix(h, q->lock_held);
+    h = hash_mix(h, q->locking_row);
+    h = hash_mix(h, q->lvlinc);
+    h = hash_mix(h, q->lastclear);
+    h = hash_mix(h, q->combo);
+    h = hash_mix(h, q->combo_simple);
+    h = hash_mix(h, q->recoveries);
+    h = hash_mix(h, q->is_recovering);
+
+    h = hash_mix(h, q->speed_curve_index);
+
+    return h;
+}
@@ -0,0 +1,17 @@
+#ifndef _state_hash_h
+#define _state_hash_h
+
+#include <stdint.h>
+#include "core.h"
+
+/* hash of everything in a qs game that later frames depend on: the mutable qrsdata fields, the player,
+   counters, field, previews/hold and the randomizer seed and history
+
+   cheap enough to run every frame; the field part comes from the row hashes qrs_setcell() and friends
+   keep up to date, so it costs QRS_FIELD_H steps rather than a pass over every cell
+
+   two runs of the same replay must produce the same sequence of hashes, so nothing here may depend on
+   pointers, rendering, the recording/playback flags or anything else that differs between them */
+uint32_t qs_state_hash(game_t *g);
+
+#endif
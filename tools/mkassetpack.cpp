@@ -0,0 +1,241 @@
+/*
+    mkassetpack.cpp - packs gfx/ and audio/ into assets.pak (format in src/asset_pack.h)
+
+    usage: mkassetpack <output> <directory>...
+    run from the directory the game's data lives in; entries are named by their path relative to it
+*/
+
+#include <dirent.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#define ASSET_PACK_FORMAT_ONLY
+#include "../src/asset_pack.h"
+
+using namespace std;
+
+struct packed_file
+{
+    string path;    // as found on disk
+    string name;    // path without extension, the key
+    int priority;
+    uint32_t size;
+};
+
+// when two files differ only by extension, the one the loose file loaders would have found first wins
+static int extension_priority(const string &path)
+{
+    static const char *order[] = {".png", ".jpg", ".ogg", ".wav"};
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of('/');
+    int i = 0;
+
+    if(dot == string::npos || (slash != string::npos && dot < slash))
+        return 4;
+
+    for(i = 0; i < 4; i++)
+    {
+        if(path.compare(dot, string::npos, order[i]) == 0)
+            return i;
+    }
+
+    return 4;
+}
+
+static string strip_extension(const string &path)
+{
+    size_t dot = path.find_last_of('.');
+    size_t slash = path.find_last_of('/');
+
+    if(dot == string::npos || (slash != string::npos && dot < slash))
+        return path;
+
+    return path.substr(0, dot);
+}
+
+static int scan_dir(const string &dir, vector<packed_file> &files)
+{
+    DIR *d = opendir(dir.c_str());
+    struct dirent *de = NULL;
+    struct stat st;
+
+    if(!d)
+    {
+        fprintf(stderr, "mkassetpack: can't open %s\n", dir.c_str());
+        return 1;
+    }
+
+    while((de = readdir(d)))
+    {
+        if(de->d_name[0] == '.')
+            continue;
+
+        string path = dir + "/" + de->d_name;
+
+        if(stat(path.c_str(), &st))
+            continue;
+
+        if(S_ISDIR(st.st_mode))
+        {
+            if(scan_dir(path, files))
+            {
+                closedir(d);
+                return 1;
+            }
+        }
+        else if(S_ISREG(st.st_mode))
+        {
+            packed_file f;
+            f.path = path;
+            f.name = strip_extension(path);
+            f.priority = extension_priority(path);
+            f.size = (uint32_t)st.st_size;
+            files.push_back(f);
+        }
+    }
+
+    closedir(d);
+    return 0;
+}
+
+static int copy_file(FILE *out, const packed_file &f)
+{
+    FILE *in = fopen(f.path.c_str(), "rb");
+    char buf[65536];
+    size_t n = 0;
+    uint32_t total = 0;
+
+    if(!in)
+    {
+        fprintf(stderr, "mkassetpack: can't read %s\n", f.path.c_str());
+        return 1;
+    }
+
+    while((n = fread(buf, 1, sizeof(buf), in)) > 0)
+    {
+        fwrite(buf, 1, n, out);
+        total += n;
+    }
+
+    fclose(in);
+
+    if(total != f.size)
+    {
+        fprintf(stderr, "mkassetpack: %s changed while being packed\n", f.path.c_str());
+        return 1;
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    if(argc < 3)
+    {
+        fprintf(stderr, "usage: mkassetpack <output> <directory>...\n");
+        return 1;
+    }
+
+    vector<packed_file> files;
+    vector<packed_file> unique;
+    vector<struct asset_pack_entry> entries;
+    vector<uint32_t> buckets;
+    string names;
+    struct asset_pack_header h;
+    uint32_t offset = 0;
+    uint32_t b = 0;
+    size_t i = 0;
+    FILE *out = NULL;
+    int rc = 0;
+
+    for(i = 2; i < (size_t)argc; i++)
+    {
+        if(scan_dir(argv[i], files))
+            return 1;
+    }
+
+    // sorted so the pack comes out the same no matter what order readdir() gives
+    sort(files.begin(), files.end(), [](const packed_file &a, const packed_file &b) {
+        return a.name != b.name ? a.name < b.name : a.priority < b.priority;
+    });
+
+    for(i = 0; i < files.size(); i++)
+    {
+        if(!unique.empty() && unique.back().name == files[i].name)
+        {
+            fprintf(stderr, "mkassetpack: skipping %s, %s has the same name\n", files[i].path.c_str(),
+                    unique.back().path.c_str());
+            continue;
+        }
+
+        unique.push_back(files[i]);
+    }
+
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, ASSET_PACK_MAGIC, 8);
+    h.version = ASSET_PACK_VERSION;
+    h.num_entries = unique.size();
+
+    // keep chains short: at least twice as many buckets as entries
+    h.num_buckets = 1;
+    while(h.num_buckets < h.num_entries * 2)
+        h.num_buckets <<= 1;
+
+    buckets.assign(h.num_buckets, ASSET_PACK_NONE);
+    entries.resize(h.num_entries);
+
+    for(i = 0; i < unique.size(); i++)
+    {
+        struct asset_pack_entry &e = entries[i];
+
+        e.name_offset = names.size();
+        e.name_len = unique[i].name.size();
+        e.hash = asset_pack_hash(unique[i].name.c_str(), e.name_len);
+        e.size = unique[i].size;
+        names += unique[i].name;
+
+        b = e.hash & (h.num_buckets - 1);
+        e.next = buckets[b];
+        buckets[b] = i;
+    }
+
+    h.names_size = names.size();
+
+    offset = sizeof(h) + h.num_buckets * sizeof(uint32_t) + h.num_entries * sizeof(struct asset_pack_entry) + h.names_size;
+    for(i = 0; i < entries.size(); i++)
+    {
+        entries[i].offset = offset;
+        offset += entries[i].size;
+    }
+
+    out = fopen(argv[1], "wb");
+    if(!out)
+    {
+        fprintf(stderr, "mkassetpack: can't write %s\n", argv[1]);
+        return 1;
+    }
+
+    fwrite(&h, sizeof(h), 1, out);
+    fwrite(buckets.data(), sizeof(uint32_t), buckets.size(), out);
+    fwrite(entries.data(), sizeof(struct asset_pack_entry), entries.size(), out);
+    fwrite(names.data(), 1, names.size(), out);
+
+    for(i = 0; i < unique.size() && !rc; i++)
+        rc = copy_file(out, unique[i]);
+
+    if(fclose(out) || rc)
+    {
+        remove(argv[1]);
+        return 1;
+    }
+
+    printf("mkassetpack: %u files, %u bytes\n", h.num_entries, offset);
+    return 0;
+}